@@ -356,6 +356,7 @@ type PlannerNodeVbMapping struct {
 
 type HandlerConfig struct {
 	N1qlPrepareAll           bool
+	PipelineBucketWrites     bool
 	LanguageCompatibility    string
 	AggDCPFeedMemCap         int64
 	CheckpointInterval       int
@@ -389,6 +390,13 @@ type HandlerConfig struct {
 	WorkerQueueMemCap        int64
 	WorkerResponseTimeout    int
 	LcbRetryCount            int
+	BucketCacheSize          int
+	BucketCacheAge           int
+	BucketCacheParsedDocs    bool
+	BucketOpTimeout          int
+	N1qlMinConnections       int
+	N1qlPrefetchRows         int
+	N1qlPrefetchBytes        int
 }
 
 type ProcessConfig struct {
@@ -108,6 +108,7 @@ type vbSeqNo struct {
 // Consumer is responsible interacting with c++ v8 worker over local tcp port
 type Consumer struct {
 	n1qlPrepareAll bool
+	pipelineBucketWrites bool
 	app         *common.AppConfig
 	bucket      string // source bucket
 	builderPool *sync.Pool
@@ -161,6 +162,13 @@ type Consumer struct {
 	executeTimerRoutineCount      int
 	executionTimeout              int
 	lcbRetryCount                 int
+	bucketCacheSize               int
+	bucketCacheAge                int
+	bucketCacheParsedDocs         bool
+	bucketOpTimeout               int
+	n1qlMinConnections            int
+	n1qlPrefetchRows              int
+	n1qlPrefetchBytes             int
 	filterVbEvents                map[uint16]struct{} // Access controlled by filterVbEventsRWMutex
 	filterVbEventsRWMutex         *sync.RWMutex
 	filterDataCh                  chan *vbSeqNo
@@ -223,6 +231,9 @@ type Consumer struct {
 	workerRespMainLoopTs        atomic.Value
 	workerRespMainLoopThreshold int
 
+	// DCP header version agreed with CPP worker at init, accessed atomically
+	dcpHeaderVersion int32
+
 	// DCP config, as they need to be tunable
 	dcpConfig map[string]interface{}
 
@@ -419,32 +419,37 @@ func (c *Consumer) sendGetLcbExceptionStats(sendToDebugger bool) {
 }
 
 func (c *Consumer) sendDcpEvent(e *memcached.DcpEvent, sendToDebugger bool) {
-	m := dcpMetadata{
-		Cas:     e.Cas,
-		DocID:   string(e.Key),
-		Expiry:  e.Expiry,
-		Flag:    e.Flags,
-		Vbucket: e.VBucket,
-		SeqNo:   e.Seqno,
-	}
-
-	metadata, err := json.Marshal(&m)
-	if err != nil {
-		logging.Errorf("CRHM[%s:%s:%s:%d] key: %ru failed to marshal metadata",
-			c.app.AppName, c.workerName, c.tcpPort, c.Pid(), string(e.Key))
-		return
+	var opcode int8
+	switch e.Opcode {
+	case mcd.DCP_MUTATION:
+		opcode = dcpMutation
+	case mcd.DCP_DELETION:
+		opcode = dcpDeletion
 	}
 
 	partition := int16(util.VbucketByKey(e.Key, cppWorkerPartitionCount))
 
 	var dcpHeader []byte
 	var hBuilder *flatbuffers.Builder
-	if e.Opcode == mcd.DCP_MUTATION {
-		dcpHeader, hBuilder = c.makeDcpMutationHeader(partition, string(metadata))
-	}
+	if !sendToDebugger && atomic.LoadInt32(&c.dcpHeaderVersion) >= dcpHeaderVersionTyped {
+		dcpHeader, hBuilder = c.makeTypedDcpHeader(opcode, partition, e)
+	} else {
+		m := dcpMetadata{
+			Cas:     e.Cas,
+			DocID:   string(e.Key),
+			Expiry:  e.Expiry,
+			Flag:    e.Flags,
+			Vbucket: e.VBucket,
+			SeqNo:   e.Seqno,
+		}
 
-	if e.Opcode == mcd.DCP_DELETION {
-		dcpHeader, hBuilder = c.makeDcpDeletionHeader(partition, string(metadata))
+		metadata, err := json.Marshal(&m)
+		if err != nil {
+			logging.Errorf("CRHM[%s:%s:%s:%d] key: %ru failed to marshal metadata",
+				c.app.AppName, c.workerName, c.tcpPort, c.Pid(), string(e.Key))
+			return
+		}
+		dcpHeader, hBuilder = c.makeDcpHeader(opcode, partition, string(metadata))
 	}
 
 	dcpPayload, pBuilder := c.makeDcpPayload(e.Key, e.Value)
@@ -4,9 +4,11 @@ import (
 	"encoding/json"
 	"strconv"
 	"strings"
+	"sync/atomic"
 	"time"
 
 	"github.com/couchbase/eventing/common"
+	"github.com/couchbase/eventing/dcp/transport/client"
 	"github.com/couchbase/eventing/gen/flatbuf/header"
 	"github.com/couchbase/eventing/gen/flatbuf/payload"
 	"github.com/couchbase/eventing/gen/flatbuf/response"
@@ -100,6 +102,13 @@ const (
 	lcbExceptions
 	curlLatencyStats
 	insight
+	dcpHeaderVersion
+)
+
+// Encodings of DCP metadata in the message header
+const (
+	dcpHeaderVersionJSON int32 = iota + 1
+	dcpHeaderVersionTyped
 )
 
 const (
@@ -123,16 +132,32 @@ func (c *Consumer) makeTimerEventHeader(partition int16) ([]byte, *flatbuffers.B
 	return c.makeHeader(timerEvent, timer, partition, "")
 }
 
-func (c *Consumer) makeDcpMutationHeader(partition int16, mutationMeta string) ([]byte, *flatbuffers.Builder) {
-	return c.makeDcpHeader(dcpMutation, partition, mutationMeta)
+func (c *Consumer) makeDcpHeader(opcode int8, partition int16, meta string) ([]byte, *flatbuffers.Builder) {
+	return c.makeHeader(dcpEvent, opcode, partition, meta)
 }
 
-func (c *Consumer) makeDcpDeletionHeader(partition int16, deletionMeta string) ([]byte, *flatbuffers.Builder) {
-	return c.makeDcpHeader(dcpDeletion, partition, deletionMeta)
-}
+func (c *Consumer) makeTypedDcpHeader(opcode int8, partition int16, e *memcached.DcpEvent) (encodedHeader []byte, builder *flatbuffers.Builder) {
+	builder = c.getBuilder()
 
-func (c *Consumer) makeDcpHeader(opcode int8, partition int16, meta string) ([]byte, *flatbuffers.Builder) {
-	return c.makeHeader(dcpEvent, opcode, partition, meta)
+	key := builder.CreateByteVector(e.Key)
+
+	header.HeaderStart(builder)
+
+	header.HeaderAddEvent(builder, dcpEvent)
+	header.HeaderAddOpcode(builder, opcode)
+	header.HeaderAddPartition(builder, partition)
+	header.HeaderAddCas(builder, e.Cas)
+	header.HeaderAddVb(builder, e.VBucket)
+	header.HeaderAddSeq(builder, e.Seqno)
+	header.HeaderAddExpiry(builder, e.Expiry)
+	header.HeaderAddFlags(builder, e.Flags)
+	header.HeaderAddKey(builder, key)
+
+	headerPos := header.HeaderEnd(builder)
+	builder.Finish(headerPos)
+
+	encodedHeader = builder.FinishedBytes()
+	return
 }
 
 func (c *Consumer) filterEventHeader(opcode int8, partition int16, meta string) ([]byte, *flatbuffers.Builder) {
@@ -350,11 +375,26 @@ func (c *Consumer) makeV8InitPayload(appName, debuggerPort, currHost, eventingDi
 	payload.PayloadAddHandlerFooters(builder, handlerFooters)
 	payload.PayloadAddN1qlConsistency(builder, n1qlConsistency)
 	payload.PayloadAddLcbRetryCount(builder, int32(c.lcbRetryCount))
+	payload.PayloadAddBucketCacheSize(builder, int32(c.bucketCacheSize))
+	payload.PayloadAddBucketCacheAge(builder, int32(c.bucketCacheAge))
+	payload.PayloadAddBucketOpTimeout(builder, int32(c.bucketOpTimeout))
+	payload.PayloadAddN1qlMinConnections(builder, int32(c.n1qlMinConnections))
+	payload.PayloadAddN1qlPrefetchRows(builder, int32(c.n1qlPrefetchRows))
+	payload.PayloadAddN1qlPrefetchBytes(builder, int32(c.n1qlPrefetchBytes))
+	payload.PayloadAddDcpHeaderVersion(builder, dcpHeaderVersionTyped)
 
 	if c.n1qlPrepareAll {
 		payload.PayloadAddN1qlPrepareAll(builder, 0x1)
 	}
 
+	if c.pipelineBucketWrites {
+		payload.PayloadAddPipelineBucketWrites(builder, 0x1)
+	}
+
+	if c.bucketCacheParsedDocs {
+		payload.PayloadAddBucketCacheParsedDocs(builder, 0x1)
+	}
+
 	msgPos := payload.PayloadEnd(builder)
 	builder.Finish(msgPos)
 
@@ -484,6 +524,16 @@ func (c *Consumer) routeResponse(msgType, opcode int8, msg string) {
 				logging.Errorf("%s [%s:%s:%d] Failed to unmarshal lcb exception stats, msg: %v err: %v",
 					logPrefix, c.workerName, c.tcpPort, c.Pid(), msg, err)
 			}
+		case dcpHeaderVersion:
+			version, err := strconv.ParseInt(msg, 10, 32)
+			if err != nil {
+				logging.Errorf("%s [%s:%s:%d] Failed to parse dcp header version, msg: %v err: %v",
+					logPrefix, c.workerName, c.tcpPort, c.Pid(), msg, err)
+				return
+			}
+			logging.Infof("%s [%s:%s:%d] Using dcp header version: %d",
+				logPrefix, c.workerName, c.tcpPort, c.Pid(), version)
+			atomic.StoreInt32(&c.dcpHeaderVersion, int32(version))
 		}
 
 	case bucketOpsResponse:
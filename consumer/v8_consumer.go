@@ -30,6 +30,7 @@ func NewConsumer(hConfig *common.HandlerConfig, pConfig *common.ProcessConfig, r
 	var b *couchbase.Bucket
 	consumer := &Consumer{
 		n1qlPrepareAll:                  hConfig.N1qlPrepareAll,
+		pipelineBucketWrites:            hConfig.PipelineBucketWrites,
 		isPausing:                       false,
 		languageCompatibility:           hConfig.LanguageCompatibility,
 		app:                             app,
@@ -60,6 +61,13 @@ func NewConsumer(hConfig *common.HandlerConfig, pConfig *common.ProcessConfig, r
 		executeTimerRoutineCount:        hConfig.ExecuteTimerRoutineCount,
 		executionTimeout:                hConfig.ExecutionTimeout,
 		lcbRetryCount:                   hConfig.LcbRetryCount,
+		bucketCacheSize:                 hConfig.BucketCacheSize,
+		bucketCacheAge:                  hConfig.BucketCacheAge,
+		bucketCacheParsedDocs:           hConfig.BucketCacheParsedDocs,
+		bucketOpTimeout:                 hConfig.BucketOpTimeout,
+		n1qlMinConnections:              hConfig.N1qlMinConnections,
+		n1qlPrefetchRows:                hConfig.N1qlPrefetchRows,
+		n1qlPrefetchBytes:               hConfig.N1qlPrefetchBytes,
 		feedbackQueueCap:                hConfig.FeedbackQueueCap,
 		feedbackReadBufferSize:          hConfig.FeedbackReadBufferSize,
 		feedbackTCPPort:                 pConfig.FeedbackSockIdentifier,
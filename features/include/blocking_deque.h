@@ -16,27 +16,31 @@
 #include <deque>
 #include <mutex>
 
-template <typename T> class BlockingDeque {
+#include "message_queue.h"
+
+template <typename T> class BlockingDeque : public MessageQueue<T> {
 public:
   BlockingDeque() = default;
   BlockingDeque(const BlockingDeque &) = delete;
   BlockingDeque &operator=(const BlockingDeque &) = delete;
 
-  void PushFront(T elem);
+  void PushFront(T elem) override;
+
+  bool PopFront(T &elem) override;
 
-  bool PopFront(T &elem);
+  bool TryPopFront(T &elem) override;
 
-  void PushBack(T elem);
+  void PushBack(T elem) override;
 
   bool PopBack(T &elem);
 
-  size_t GetMemory();
+  size_t GetMemory() override;
 
-  size_t GetSize();
+  size_t GetSize() override;
 
-  void Clear();
+  void Clear() override;
 
-  void Close();
+  void Close() override;
 
 private:
   std::deque<T> elems_;
@@ -65,6 +69,16 @@ template <typename T> bool BlockingDeque<T>::PopFront(T &elem) {
   return true;
 }
 
+template <typename T> bool BlockingDeque<T>::TryPopFront(T &elem) {
+  std::lock_guard<std::mutex> lck(lock_);
+  if (elems_.empty())
+    return false;
+  elem = std::move(elems_.front());
+  mem_size_ -= elem->GetSize();
+  elems_.pop_front();
+  return true;
+}
+
 template <typename T> void BlockingDeque<T>::PushBack(T elem) {
   std::unique_lock<std::mutex> lck(lock_);
   mem_size_ += elem->GetSize();
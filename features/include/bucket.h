@@ -12,13 +12,19 @@
 #ifndef BUCKET_H
 #define BUCKET_H
 
+#include <array>
+#include <chrono>
+#include <functional>
 #include <libcouchbase/couchbase.h>
+#include <list>
 #include <memory>
 #include <string>
 #include <tuple>
 #include <utility>
 #include <v8.h>
+#include <vector>
 
+#include "bucket_cache.h"
 #include "error.h"
 #include "info.h"
 #include "isolate_data.h"
@@ -58,6 +64,12 @@ public:
   std::tuple<Error, std::unique_ptr<lcb_error_t>, std::unique_ptr<Result>>
   Get(const std::string &key);
 
+  // Fetches all the keys in a single round trip, the results are in the
+  // same order as keys
+  std::tuple<Error, std::unique_ptr<lcb_error_t>,
+             std::unique_ptr<std::vector<Result>>>
+  GetMulti(const std::vector<std::string> &keys);
+
   std::tuple<Error, std::unique_ptr<lcb_error_t>, std::unique_ptr<Result>>
   SetWithXattr(const std::string &key, const std::string &value);
 
@@ -72,14 +84,74 @@ public:
 
   lcb_t GetConnection() const { return connection_; }
 
+  const std::string &GetName() const { return bucket_name_; }
+
+  // Sends out the writes deferred in pipelined mode and waits for them
+  void FlushPendingWrites();
+
 private:
+  // In pipelined mode, writes are only scheduled on the connection and go out
+  // along with the next read or when the handler returns, whichever is first
+  struct PendingWrite {
+    std::string key;
+    bool is_delete{false};
+    Result result;
+    // Schedules the write again, with the given cookie
+    std::function<lcb_error_t(Result *)> schedule;
+  };
+
+  // Sub-document specs of the _eventing xattrs, which are the same for all
+  // the writes to the source bucket. Only the spec of the document itself is
+  // patched per write
+  class XattrSpecs {
+  public:
+    static constexpr std::size_t num_specs = 4;
+
+    explicit XattrSpecs(std::string function_instance_id);
+
+    XattrSpecs(const XattrSpecs &) = delete;
+    XattrSpecs &operator=(const XattrSpecs &) = delete;
+
+    // The specs remain valid until the next call
+    lcb_SDSPEC *ForSet(const std::string &value);
+    lcb_SDSPEC *ForDelete() { return delete_specs_.data(); }
+
+  private:
+    void InitXattrSpecs(std::array<lcb_SDSPEC, num_specs> &specs) const;
+
+    const std::string function_instance_id_;
+    std::array<lcb_SDSPEC, num_specs> set_specs_;
+    std::array<lcb_SDSPEC, num_specs> delete_specs_;
+  };
+
   Error FormatErrorAndDestroyConn(const std::string &message,
                                   const lcb_error_t &error) const;
 
+  std::chrono::steady_clock::time_point GetRetryDeadline() const;
+
+  bool IsPipelined() const;
+
+  lcb_error_t ScheduleGets(const std::vector<std::string> &keys,
+                           std::vector<Result> &results);
+
+  bool ScheduleWrite(const std::string &key, bool is_delete,
+                     std::function<lcb_error_t(Result *)> schedule);
+
+  void RescheduleFailedWrites();
+
+  // To be called after every lcb_wait as it completes the pending writes too.
+  // Writes which failed with a retriable error are kept for FlushPendingWrites
+  void CompletePendingWrites();
+
+  void FailPendingWrite(const PendingWrite &pending_write);
+
   v8::Isolate *isolate_{nullptr};
   std::string bucket_name_;
   lcb_t connection_{nullptr};
   bool is_connected_{false};
+  std::list<PendingWrite> pending_writes_;
+  std::shared_ptr<BucketCache> cache_;
+  std::shared_ptr<XattrSpecs> xattr_specs_;
 };
 
 class BucketBinding {
@@ -96,6 +168,18 @@ public:
   Error InstallBinding(v8::Isolate *isolate,
                        const v8::Local<v8::Context> &context);
 
+  void FlushPendingWrites() { bucket_.FlushPendingWrites(); }
+
+  // A read through reader doesn't go over the connection of this binding, so
+  // it observes the writes pending here only once they are flushed
+  bool MustFlushFor(const Bucket *reader) const {
+    return &bucket_ != reader && bucket_name_ == reader->GetName();
+  }
+
+  // getMulti(bucket, [keys]) returns an object which maps each key to either
+  // {value} or {error}
+  static void GetMulti(const v8::FunctionCallbackInfo<v8::Value> &args);
+
 private:
   static void HandleBucketOpFailure(v8::Isolate *isolate, lcb_t connection,
                                     lcb_error_t error);
@@ -174,17 +258,24 @@ private:
   std::string bucket_alias_;
   std::shared_ptr<BucketFactory> factory_;
   Bucket bucket_;
+  std::shared_ptr<ParsedDocCache> parsed_doc_cache_;
 
   enum InternalFields {
     kBucketInstance,
     kBlockMutation,
     kIsSourceBucket,
+    kParsedDocCache,
     kInternalFieldsCount
   };
 };
 
+void GetMultiFunction(const v8::FunctionCallbackInfo<v8::Value> &args);
+
 // TODO : Must be implemented by the component that wants to use Bucket
 void AddLcbException(const IsolateData *isolate_data, lcb_error_t error);
 std::string GetFunctionInstanceID(v8::Isolate *isolate);
+std::chrono::nanoseconds GetRemainingExecutionTime(v8::Isolate *isolate);
+void FlushBucketWrites(v8::Isolate *isolate);
+void FlushBucketWrites(v8::Isolate *isolate, const Bucket *reader);
 
 #endif
\ No newline at end of file
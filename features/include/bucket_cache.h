@@ -0,0 +1,108 @@
+// Copyright (c) 2019 Couchbase, Inc.
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//     http://www.apache.org/licenses/LICENSE-2.0
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an "AS IS"
+// BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express
+// or implied. See the License for the specific language governing
+// permissions and limitations under the License.
+
+#ifndef BUCKET_CACHE_H
+#define BUCKET_CACHE_H
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <libcouchbase/couchbase.h>
+#include <list>
+#include <string>
+#include <unordered_map>
+#include <v8.h>
+
+extern std::atomic<int64_t> bucket_cache_hit;
+extern std::atomic<int64_t> bucket_cache_miss;
+extern std::atomic<int64_t> bucket_cache_eviction;
+extern std::atomic<int64_t> parsed_doc_cache_hit;
+extern std::atomic<int64_t> parsed_doc_cache_miss;
+
+// Bounded LRU cache of the raw documents read through a bucket binding. An
+// entry lives for at most max_age, writes made through the same binding
+// invalidate it right away. It's owned by a single V8Worker, hence not
+// thread-safe
+class BucketCache {
+public:
+  struct Entry {
+    std::string value;
+    lcb_CAS cas{0};
+  };
+
+  BucketCache(std::size_t capacity, std::chrono::milliseconds max_age)
+      : capacity_(capacity), max_age_(max_age) {}
+
+  BucketCache(const BucketCache &) = delete;
+  BucketCache &operator=(const BucketCache &) = delete;
+
+  // Returns nullptr when key isn't cached or its entry has expired. The entry
+  // remains valid until the next call to Put or Invalidate
+  const Entry *Get(const std::string &key);
+
+  void Put(const std::string &key, const std::string &value, lcb_CAS cas);
+
+  void Invalidate(const std::string &key);
+
+private:
+  typedef std::chrono::steady_clock Clock;
+
+  struct Node {
+    std::string key;
+    Entry entry;
+    Clock::time_point expiry;
+  };
+
+  const std::size_t capacity_;
+  const std::chrono::milliseconds max_age_;
+
+  // Most recently used first
+  std::list<Node> lru_;
+  std::unordered_map<std::string, std::list<Node>::iterator> index_;
+};
+
+// Deep-frozen objects parsed from the documents of a read-only binding. The
+// same object is handed out across invocations for as long as the CAS of the
+// document remains the same. Owned by a single V8Worker like BucketCache
+class ParsedDocCache {
+public:
+  ParsedDocCache(v8::Isolate *isolate, std::size_t capacity)
+      : isolate_(isolate), capacity_(capacity) {}
+
+  ParsedDocCache(const ParsedDocCache &) = delete;
+  ParsedDocCache &operator=(const ParsedDocCache &) = delete;
+
+  // Returns false when key isn't cached or was cached at a different CAS
+  bool Get(const std::string &key, lcb_CAS cas, v8::Local<v8::Value> *doc);
+
+  // Freezes doc before caching it
+  bool Put(const v8::Local<v8::Context> &context, const std::string &key,
+           lcb_CAS cas, const v8::Local<v8::Value> &doc);
+
+private:
+  struct Node {
+    std::string key;
+    lcb_CAS cas;
+    v8::Global<v8::Value> doc;
+  };
+
+  bool DeepFreeze(const v8::Local<v8::Context> &context,
+                  const v8::Local<v8::Value> &doc) const;
+
+  v8::Isolate *isolate_;
+  const std::size_t capacity_;
+
+  // Most recently used first
+  std::list<Node> lru_;
+  std::unordered_map<std::string, std::list<Node>::iterator> index_;
+};
+
+#endif
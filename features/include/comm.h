@@ -12,7 +12,11 @@
 #ifndef COMM_H
 #define COMM_H
 
+#include <atomic>
+#include <chrono>
+#include <mutex>
 #include <string>
+#include <thread>
 #include <unordered_map>
 #include <v8.h>
 #include <vector>
@@ -33,23 +37,116 @@ struct KVNodesInfo {
   std::string msg;
 };
 
+extern std::atomic<int64_t> kv_nodes_refresh_count;
+extern std::atomic<int64_t> kv_nodes_refresh_failure;
+extern std::atomic<int64_t> kv_nodes_refresh_latency_us;
+
+// Credentials of the KV and query endpoints, shared by all the workers in the
+// process. An entry is served for at most max_age and becomes due for refresh
+// halfway through, provided it was read since it was fetched
+class CredsCache {
+public:
+  typedef std::chrono::steady_clock Clock;
+
+  static constexpr std::chrono::seconds max_age{120};
+  static constexpr std::chrono::seconds refresh_age{60};
+
+  CredsCache() = default;
+  CredsCache(const CredsCache &) = delete;
+  CredsCache &operator=(const CredsCache &) = delete;
+
+  // Returns false when endpoint isn't cached or its entry has expired
+  bool Get(const std::string &endpoint, CredsInfo &info);
+
+  // Caches info if it's valid, releases the claim on endpoint regardless
+  void Put(const std::string &endpoint, const CredsInfo &info);
+
+  // Claims the endpoints that are due for refresh, so that only one of the
+  // workers refreshes any given endpoint. Drops the expired entries
+  std::vector<std::string> ClaimStale();
+
+  void Clear();
+
+private:
+  struct Entry {
+    CredsInfo info;
+    Clock::time_point fetched;
+    bool is_refreshing{false};
+    bool is_read{false};
+  };
+
+  std::mutex lock_;
+  std::unordered_map<std::string, Entry> entries_;
+};
+
+// Addresses of the active KV nodes, shared by all the workers in the process
+// much like CredsCache. Dropped upon connection bootstrap failures, as the
+// topology may have changed
+class KVNodesCache {
+public:
+  typedef std::chrono::steady_clock Clock;
+
+  static constexpr std::chrono::seconds max_age{60};
+  static constexpr std::chrono::seconds refresh_age{15};
+
+  KVNodesCache() = default;
+  KVNodesCache(const KVNodesCache &) = delete;
+  KVNodesCache &operator=(const KVNodesCache &) = delete;
+
+  // Returns false when the nodes aren't cached or have expired
+  bool Get(KVNodesInfo &info);
+
+  // Caches info if it's valid, releases the claim regardless
+  void Put(const KVNodesInfo &info);
+
+  // Returns true if the nodes are due for refresh, were read since they were
+  // fetched and weren't claimed yet
+  bool ClaimStale();
+
+  void Clear();
+
+  // Milliseconds since the nodes were fetched, -1 if they aren't cached
+  int64_t GetAge();
+
+private:
+  std::mutex lock_;
+  KVNodesInfo info_;
+  Clock::time_point fetched_;
+  bool is_cached_{false};
+  bool is_refreshing_{false};
+  bool is_read_{false};
+};
+
 // Channel to communicate to eventing-producer through CURL
 class Communicator {
 public:
   Communicator(const std::string &host_ip, const std::string &host_port,
                const std::string &usr, const std::string &key, bool ssl,
                const std::string &app_name, v8::Isolate *isolate);
+  ~Communicator();
 
   CredsInfo GetCreds(const std::string &endpoint);
   KVNodesInfo GetKVNodes();
   void WriteDebuggerURL(const std::string &url);
+  // Drops the cached credentials, to be called upon auth errors
   void Refresh();
+  // Drops the cached KV nodes, to be called upon bootstrap failures
+  void RefreshKVNodes();
+
+  static int64_t GetKVNodesCacheAge() { return kv_nodes_cache_.GetAge(); }
 
 private:
   CredsInfo ExtractCredentials(const std::string &encoded_str);
+  CredsInfo FetchCreds(const std::string &endpoint);
+  KVNodesInfo FetchKVNodes();
+  KVNodesInfo GetKVNodesFromProducer();
+  static void StartRefresh();
+  static void RefreshStale();
+
+  static CredsCache creds_cache_;
+  static KVNodesCache kv_nodes_cache_;
 
   v8::Isolate *isolate_;
-  std::unordered_map<std::string, CredsInfo> creds_cache_;
   CurlClient curl_;
   std::string app_name_;
   std::string get_creds_url_;
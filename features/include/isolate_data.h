@@ -46,7 +46,14 @@ struct IsolateData {
   long curl_timeout{0};
   int n1ql_consistency{0};
   int lcb_retry_count{0};
+  int bucket_cache_size{0};
+  int bucket_cache_age{0};
+  bool bucket_cache_parsed_docs{false};
+  int bucket_op_timeout{0};
   bool n1ql_prepare_all{false};
+  int n1ql_prefetch_rows{0};
+  int n1ql_prefetch_bytes{0};
+  bool pipeline_bucket_writes{false};
 
   Query::Manager *query_mgr{nullptr};
   Query::Iterable *query_iterable{nullptr};
@@ -62,6 +62,7 @@ public:
 
   void ThrowKVError(const std::string &err_msg);
   void ThrowKVError(lcb_t instance, lcb_error_t error);
+  v8::Local<v8::Value> NewKVError(lcb_t instance, lcb_error_t error);
   void ThrowN1QLError(const std::string &err_msg);
   void ThrowEventingError(const std::string &err_msg);
   void ThrowCurlError(const std::string &err_msg);
@@ -12,9 +12,14 @@
 #ifndef COUCHBASE_LCB_UTILS_H
 #define COUCHBASE_LCB_UTILS_H
 
+#include <atomic>
+#include <chrono>
 #include <libcouchbase/couchbase.h>
+#include <limits>
 #include <thread>
 
+#include "retry_util.h"
+
 struct Result {
   lcb_CAS cas{0};
   lcb_error_t rc{LCB_SUCCESS};
@@ -25,6 +30,12 @@ struct Result {
 
 constexpr int max_lcb_retry_count = 5;
 
+// Delay before the first retry of a failed lcb operation, doubles thereafter
+constexpr int64_t lcb_retry_initial_delay_ms = 20;
+
+extern std::atomic<int64_t> lcb_retry_attempts;
+extern std::atomic<int64_t> lcb_retry_time_us;
+
 const char *GetUsername(void *cookie, const char *host, const char *port,
                         const char *bucket);
 
@@ -58,23 +69,51 @@ std::pair<lcb_error_t, Result> LcbGetCounter(lcb_t instance,
 
 bool IsRetriable(lcb_error_t error);
 
-template <typename CmdType, typename Callable>
-std::pair<lcb_error_t, Result> RetryLcbCommand(lcb_t instance, CmdType &cmd,
-                                               int max_retry_count,
-                                               Callable &&callable) {
-  int retry_count = 0;
-  std::pair<lcb_error_t, Result> result;
-  while (true) {
-    result = callable(instance, cmd);
-    if (result.first == LCB_SUCCESS || !IsRetriable(result.first) ||
-        (!max_retry_count && retry_count >= max_retry_count))
-      break;
-    ++retry_count;
-    std::this_thread::sleep_for(std::chrono::milliseconds(200));
+// Retries callable with a jittered exponential backoff, till it either
+// succeeds or max_retry_count retries are done (0 doesn't bound the count) or
+// the next attempt can't begin before deadline
+template <typename Predicate, typename Callable>
+auto RetryLcbOperation(int max_retry_count,
+                       const std::chrono::steady_clock::time_point &deadline,
+                       Predicate &&isRetriable, Callable &&callable)
+    -> decltype(callable()) {
+  typedef std::chrono::steady_clock Clock;
+
+  auto attempts = 0;
+  Clock::time_point first_attempt_end;
+  auto result = RetryWithExponentialBackoff(
+      deadline,
+      max_retry_count > 0 ? max_retry_count : std::numeric_limits<int>::max(),
+      lcb_retry_initial_delay_ms, isRetriable, [&]() {
+        auto status = callable();
+        if (++attempts == 1) {
+          first_attempt_end = Clock::now();
+        }
+        return status;
+      });
+
+  if (attempts > 1) {
+    lcb_retry_attempts += attempts - 1;
+    lcb_retry_time_us += std::chrono::duration_cast<std::chrono::microseconds>(
+                             Clock::now() - first_attempt_end)
+                             .count();
   }
   return result;
 }
 
+template <typename CmdType, typename Callable>
+std::pair<lcb_error_t, Result>
+RetryLcbCommand(lcb_t instance, CmdType &cmd, int max_retry_count,
+                const std::chrono::steady_clock::time_point &deadline,
+                Callable &&callable) {
+  return RetryLcbOperation(
+      max_retry_count, deadline,
+      [](const std::pair<lcb_error_t, Result> &result) {
+        return IsRetriable(result.first);
+      },
+      [&]() { return callable(instance, cmd); });
+}
+
 extern struct lcb_logprocs_st evt_logger;
 
 #endif // COUCHBASE_LCB_UTILS_H
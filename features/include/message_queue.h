@@ -0,0 +1,42 @@
+// Copyright (c) 2019 Couchbase, Inc.
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//     http://www.apache.org/licenses/LICENSE-2.0
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an "AS IS"
+// BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express
+// or implied. See the License for the specific language governing
+// permissions and limitations under the License.
+
+#ifndef COUCHBASE_MESSAGE_QUEUE_H
+#define COUCHBASE_MESSAGE_QUEUE_H
+
+#include <cstddef>
+
+// Interface of the queue that feeds a V8Worker. PushFront is reserved for
+// high priority messages, which must be popped ahead of those pushed at the
+// back. PopFront blocks until an element is available or the queue is closed,
+// while TryPopFront returns right away if the queue is empty
+template <typename T> class MessageQueue {
+public:
+  virtual ~MessageQueue() = default;
+
+  virtual void PushFront(T elem) = 0;
+
+  virtual bool PopFront(T &elem) = 0;
+
+  virtual bool TryPopFront(T &elem) = 0;
+
+  virtual void PushBack(T elem) = 0;
+
+  virtual size_t GetMemory() = 0;
+
+  virtual size_t GetSize() = 0;
+
+  virtual void Clear() = 0;
+
+  virtual void Close() = 0;
+};
+
+#endif // COUCHBASE_MESSAGE_QUEUE_H
@@ -16,6 +16,7 @@
 #include <cassert>
 #include <chrono>
 #include <functional>
+#include <random>
 #include <thread>
 #include <type_traits>
 
@@ -95,4 +96,59 @@ R RetryWithExponentialBackoff(int max_retry_count,
   }
 }
 
+// Same as above, but each delay is picked at random from [delay/2, delay] so
+// that the callers which failed together don't retry in lockstep. Gives up
+// once the next attempt can't begin before deadline
+template <typename Predicate, typename Callable, typename... Args,
+          // figure out what the callable returns
+          typename R = typename std::decay<
+              typename std::result_of<Callable &(Args...)>::type>::type,
+          // require that Predicate is actually a Predicate
+          typename std::enable_if<
+              std::is_convertible<typename std::result_of<Predicate &(R)>::type,
+                                  bool>::value,
+              int>::type = 0>
+R RetryWithExponentialBackoff(
+    const std::chrono::steady_clock::time_point &deadline, int max_retry_count,
+    int64_t initial_delay_milliseconds, Predicate &&isRetriable,
+    Callable &&callable, Args &&... args) {
+  static thread_local std::minstd_rand engine(std::random_device{}());
+
+  int retry_count = 0;
+  while (true) {
+    auto status = callable(std::forward<Args>(args)...);
+    if (!isRetriable(status)) {
+      return status;
+    }
+
+    if (retry_count >= max_retry_count) {
+      // Return status and abort retry
+      return status;
+    }
+    int64_t delay_milliseconds = 0;
+    if (initial_delay_milliseconds > 0) {
+      // Doubling beyond this would only overflow, max_backoff applies anyway
+      const auto shift = std::min(retry_count, 30);
+      delay_milliseconds = std::min(initial_delay_milliseconds << shift,
+                                    max_backoff_milliseconds);
+      std::uniform_int_distribution<int64_t> jitter(delay_milliseconds / 2,
+                                                    delay_milliseconds);
+      delay_milliseconds = jitter(engine);
+    }
+    const auto delay = std::chrono::milliseconds(delay_milliseconds);
+    if (std::chrono::steady_clock::now() + delay >= deadline) {
+      LOG(logTrace) << "Callable execution failed and won't be retried as "
+                       "the deadline would be exceeded (attempt "
+                    << (retry_count + 1) << ")" << std::endl;
+      return status;
+    }
+    LOG(logTrace) << "Callable execution failed and will be retried in "
+                  << delay_milliseconds << " milliseconds (attempt "
+                  << (retry_count + 1) << " out of " << max_retry_count << ")"
+                  << std::endl;
+    std::this_thread::sleep_for(delay);
+    retry_count++;
+  }
+}
+
 #endif
@@ -0,0 +1,291 @@
+// Copyright (c) 2019 Couchbase, Inc.
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//     http://www.apache.org/licenses/LICENSE-2.0
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an "AS IS"
+// BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express
+// or implied. See the License for the specific language governing
+// permissions and limitations under the License.
+
+#ifndef COUCHBASE_RING_QUEUE_H
+#define COUCHBASE_RING_QUEUE_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+#include "message_queue.h"
+
+// Bounded lock-free ring, safe for multiple producers and consumers. Each
+// cell carries a sequence number which tells whether it is ready to be
+// written to or read from at a given position
+template <typename T> class BoundedRing {
+public:
+  // capacity must be a power of 2
+  explicit BoundedRing(size_t capacity);
+  BoundedRing(const BoundedRing &) = delete;
+  BoundedRing &operator=(const BoundedRing &) = delete;
+
+  // elem is left untouched when the ring is full
+  bool TryPush(T &elem);
+
+  bool TryPop(T &elem);
+
+private:
+  struct Cell {
+    std::atomic<size_t> sequence;
+    T data;
+  };
+
+  const size_t mask_;
+  std::unique_ptr<Cell[]> cells_;
+  alignas(64) std::atomic<size_t> enqueue_pos_{0};
+  alignas(64) std::atomic<size_t> dequeue_pos_{0};
+};
+
+// Lock-free alternative to BlockingDeque. Elements pushed at the front go into
+// a separate priority lane which is always drained first. A consumer finding
+// both lanes empty spins, then yields, and only then parks on a condition
+// variable, so producers take the mutex only when a consumer is parked.
+// Producers never wait: a lane whose ring is full spills over into a locked
+// list, since the producer is the uv thread shared by all the workers
+template <typename T> class RingQueue : public MessageQueue<T> {
+public:
+  RingQueue(size_t capacity, size_t priority_capacity);
+  RingQueue(const RingQueue &) = delete;
+  RingQueue &operator=(const RingQueue &) = delete;
+
+  void PushFront(T elem) override;
+
+  bool PopFront(T &elem) override;
+
+  bool TryPopFront(T &elem) override;
+
+  void PushBack(T elem) override;
+
+  size_t GetMemory() override;
+
+  size_t GetSize() override;
+
+  void Clear() override;
+
+  void Close() override;
+
+private:
+  // Once an element has spilled over, the following ones go to the overflow
+  // list as well until it's drained, which keeps them in order
+  struct Lane {
+    explicit Lane(size_t capacity) : ring(capacity) {}
+
+    BoundedRing<T> ring;
+    std::mutex overflow_lock;
+    std::deque<T> overflow;
+    std::atomic<size_t> overflow_size{0};
+  };
+
+  void Push(Lane &lane, T elem);
+  bool TryPop(Lane &lane, T &elem);
+  bool TryPop(T &elem);
+  void Notify();
+
+  static const int spin_count_ = 128;
+  static const int yield_count_ = 64;
+
+  Lane priority_lane_;
+  Lane lane_;
+  std::atomic<size_t> size_{0};
+  std::atomic<size_t> mem_size_{0};
+  std::atomic<bool> closed_{false};
+
+  std::atomic<int> waiters_{0};
+  std::mutex lock_;
+  std::condition_variable cond_;
+};
+
+template <typename T>
+BoundedRing<T>::BoundedRing(size_t capacity)
+    : mask_(capacity - 1), cells_(new Cell[capacity]) {
+  for (size_t i = 0; i < capacity; ++i) {
+    cells_[i].sequence.store(i, std::memory_order_relaxed);
+  }
+}
+
+template <typename T> bool BoundedRing<T>::TryPush(T &elem) {
+  auto pos = enqueue_pos_.load(std::memory_order_relaxed);
+  Cell *cell;
+  for (;;) {
+    cell = &cells_[pos & mask_];
+    auto seq = cell->sequence.load(std::memory_order_acquire);
+    auto diff = static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos);
+    if (diff == 0) {
+      if (enqueue_pos_.compare_exchange_weak(pos, pos + 1,
+                                             std::memory_order_relaxed)) {
+        break;
+      }
+    } else if (diff < 0) {
+      return false;
+    } else {
+      pos = enqueue_pos_.load(std::memory_order_relaxed);
+    }
+  }
+
+  cell->data = std::move(elem);
+  cell->sequence.store(pos + 1, std::memory_order_release);
+  return true;
+}
+
+template <typename T> bool BoundedRing<T>::TryPop(T &elem) {
+  auto pos = dequeue_pos_.load(std::memory_order_relaxed);
+  Cell *cell;
+  for (;;) {
+    cell = &cells_[pos & mask_];
+    auto seq = cell->sequence.load(std::memory_order_acquire);
+    auto diff = static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos + 1);
+    if (diff == 0) {
+      if (dequeue_pos_.compare_exchange_weak(pos, pos + 1,
+                                             std::memory_order_relaxed)) {
+        break;
+      }
+    } else if (diff < 0) {
+      return false;
+    } else {
+      pos = dequeue_pos_.load(std::memory_order_relaxed);
+    }
+  }
+
+  elem = std::move(cell->data);
+  cell->sequence.store(pos + mask_ + 1, std::memory_order_release);
+  return true;
+}
+
+template <typename T>
+RingQueue<T>::RingQueue(size_t capacity, size_t priority_capacity)
+    : priority_lane_(priority_capacity), lane_(capacity) {}
+
+template <typename T> void RingQueue<T>::PushFront(T elem) {
+  Push(priority_lane_, std::move(elem));
+}
+
+template <typename T> void RingQueue<T>::PushBack(T elem) {
+  Push(lane_, std::move(elem));
+}
+
+template <typename T> void RingQueue<T>::Push(Lane &lane, T elem) {
+  if (closed_.load(std::memory_order_acquire)) {
+    return;
+  }
+
+  // Account for the element up front, the consumer may pop it before
+  // TryPush returns
+  size_.fetch_add(1, std::memory_order_relaxed);
+  mem_size_.fetch_add(elem->GetSize(), std::memory_order_relaxed);
+
+  if (lane.overflow_size.load(std::memory_order_acquire) > 0 ||
+      !lane.ring.TryPush(elem)) {
+    std::lock_guard<std::mutex> lck(lane.overflow_lock);
+    lane.overflow.emplace_back(std::move(elem));
+    lane.overflow_size.fetch_add(1, std::memory_order_release);
+  }
+  Notify();
+}
+
+template <typename T> void RingQueue<T>::Notify() {
+  // Pairs with the fence in PopFront - either the parked consumer is seen
+  // here or the pushed element is seen there
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  if (waiters_.load(std::memory_order_relaxed) > 0) {
+    std::lock_guard<std::mutex> lck(lock_);
+    cond_.notify_one();
+  }
+}
+
+// The ring holds the older elements when both have some
+template <typename T> bool RingQueue<T>::TryPop(Lane &lane, T &elem) {
+  if (lane.ring.TryPop(elem)) {
+    return true;
+  }
+  if (lane.overflow_size.load(std::memory_order_acquire) == 0) {
+    return false;
+  }
+
+  std::lock_guard<std::mutex> lck(lane.overflow_lock);
+  if (lane.overflow.empty()) {
+    return false;
+  }
+  elem = std::move(lane.overflow.front());
+  lane.overflow.pop_front();
+  lane.overflow_size.fetch_sub(1, std::memory_order_release);
+  return true;
+}
+
+template <typename T> bool RingQueue<T>::TryPop(T &elem) {
+  if (!TryPop(priority_lane_, elem) && !TryPop(lane_, elem)) {
+    return false;
+  }
+  size_.fetch_sub(1, std::memory_order_relaxed);
+  mem_size_.fetch_sub(elem->GetSize(), std::memory_order_relaxed);
+  return true;
+}
+
+template <typename T> bool RingQueue<T>::PopFront(T &elem) {
+  for (int attempt = 0;; ++attempt) {
+    if (TryPop(elem)) {
+      return true;
+    }
+    if (closed_.load(std::memory_order_acquire)) {
+      return false;
+    }
+    if (attempt < spin_count_) {
+      continue;
+    }
+    if (attempt < spin_count_ + yield_count_) {
+      std::this_thread::yield();
+      continue;
+    }
+
+    std::unique_lock<std::mutex> lck(lock_);
+    waiters_.fetch_add(1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (TryPop(elem)) {
+      waiters_.fetch_sub(1, std::memory_order_relaxed);
+      return true;
+    }
+    if (!closed_.load(std::memory_order_acquire)) {
+      cond_.wait(lck);
+    }
+    waiters_.fetch_sub(1, std::memory_order_relaxed);
+    attempt = 0;
+  }
+}
+
+template <typename T> bool RingQueue<T>::TryPopFront(T &elem) {
+  return TryPop(elem);
+}
+
+template <typename T> size_t RingQueue<T>::GetMemory() {
+  return mem_size_.load(std::memory_order_relaxed);
+}
+
+template <typename T> size_t RingQueue<T>::GetSize() {
+  return size_.load(std::memory_order_relaxed);
+}
+
+template <typename T> void RingQueue<T>::Clear() {
+  T elem;
+  while (TryPop(elem)) {
+  }
+}
+
+template <typename T> void RingQueue<T>::Close() {
+  closed_.store(true, std::memory_order_release);
+  std::lock_guard<std::mutex> lck(lock_);
+  cond_.notify_all();
+}
+
+#endif // COUCHBASE_RING_QUEUE_H
@@ -94,9 +94,27 @@ public:
              const std::vector<std::string> &handler_headers,
              const std::vector<std::string> &handler_footers,
              const std::string &source_bucket = "");
+  // context must already have the transpiler bundle loaded, as the one in
+  // StartupSnapshot does
+  Transpiler(v8::Isolate *isolate, const v8::Local<v8::Context> &context,
+             const std::string &transpiler_src,
+             const std::vector<std::string> &handler_headers,
+             const std::vector<std::string> &handler_footers,
+             const std::string &source_bucket = "");
   ~Transpiler();
 
-  v8::Local<v8::Value> ExecTranspiler(const std::string &function,
+  static v8::Local<v8::ObjectTemplate> NewGlobalObj(v8::Isolate *isolate);
+  static void Log(const v8::FunctionCallbackInfo<v8::Value> &args);
+
+  // Functions of transpiler.js that are called from C++
+  enum Function {
+    kCompile,
+    kAddHeadersAndFooters,
+    kGetCodeVersion,
+    kNumFunctions
+  };
+
+  v8::Local<v8::Value> ExecTranspiler(Function function,
                                       v8::Local<v8::Value> args[],
                                       const int &args_len);
   CompilationInfo Compile(const std::string &plain_js);
@@ -106,7 +124,9 @@ public:
   static void LogCompilationInfo(const CompilationInfo &info);
 
 private:
-  static void Log(const v8::FunctionCallbackInfo<v8::Value> &args);
+  bool LoadBundle(const v8::Local<v8::Context> &context);
+  bool GetFunction(const v8::Local<v8::Context> &context, Function function,
+                   v8::Local<v8::Function> *function_ref);
   CompilationInfo
   ComposeCompilationInfo(v8::Local<v8::Value> &compiler_result);
   std::string ComposeDescription(int code);
@@ -117,6 +137,8 @@ private:
   const std::string source_bucket_;
   std::vector<std::string> handler_headers_;
   std::vector<std::string> handler_footers_;
+  bool is_bundle_loaded_{false};
+  v8::Persistent<v8::Function> functions_[kNumFunctions];
 };
 
 #endif
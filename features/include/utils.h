@@ -20,6 +20,7 @@
 #include <limits>
 #include <sstream>
 #include <string>
+#include <string_view>
 #include <unordered_map>
 #include <v8.h>
 #include <vector>
@@ -170,6 +171,7 @@ int WinSprintf(char **strp, const char *fmt, ...);
 
 v8::Local<v8::String> v8Str(v8::Isolate *isolate, const char *str);
 v8::Local<v8::String> v8Str(v8::Isolate *isolate, const std::string &str);
+v8::Local<v8::String> v8Str(v8::Isolate *isolate, std::string_view str);
 v8::Local<v8::Name> v8Name(v8::Isolate *isolate, uint32_t key);
 v8::Local<v8::Array> v8Array(v8::Isolate *isolate,
                              const std::vector<std::string> &from);
@@ -204,7 +206,7 @@ void UrlDecodeFunction(const v8::FunctionCallbackInfo<v8::Value> &args);
 
 void Crc64Function(const v8::FunctionCallbackInfo<v8::Value> &args);
 
-std::string GetConnectionStr(const std::string &end_point,
+std::string GetConnectionStr(const std::vector<std::string> &end_points,
                              const std::string &bucket_name);
 
 std::string BuildUrl(const std::string &host, const std::string &path);
@@ -27,6 +27,7 @@ if (NOT EVENTING_QUERY_FOUND)
 
     set(EVENTING_QUERY_SRC
             ${QUERY_DIR}/src/iterator.cc
+            ${QUERY_DIR}/src/executor.cc
             ${QUERY_DIR}/src/iterable.cc
             ${QUERY_DIR}/src/conn-pool.cc
             ${QUERY_DIR}/src/manager.cc
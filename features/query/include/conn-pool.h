@@ -12,15 +12,25 @@
 #ifndef CONN_POOL_H
 #define CONN_POOL_H
 
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
 #include <libcouchbase/couchbase.h>
 #include <mutex>
 #include <queue>
 #include <string>
+#include <thread>
 #include <utility>
 #include <v8.h>
 
 #include "info.h"
 
+extern std::atomic<int64_t> n1ql_conn_create_count;
+extern std::atomic<int64_t> n1ql_conn_create_failure;
+extern std::atomic<int64_t> n1ql_conn_create_time_us;
+extern std::atomic<int64_t> n1ql_conn_discarded;
+extern std::atomic<int64_t> n1ql_pool_wait_time_us;
+
 namespace Connection {
 struct Info : public ::Info {
   Info() = delete;
@@ -31,12 +41,14 @@ struct Info : public ::Info {
   lcb_t connection{nullptr};
 };
 
+// Connections are created outside of pool_sync_, a slot is reserved for each
+// one by counting it in current_size_ beforehand
 class Pool {
 public:
-  explicit Pool(std::size_t capacity, std::string conn_str,
-                v8::Isolate *isolate)
+  explicit Pool(std::size_t capacity, std::size_t min_size,
+                std::string conn_str, v8::Isolate *isolate)
       : isolate_(isolate), src_bucket_(std::move(conn_str)),
-        capacity_(capacity) {}
+        capacity_(capacity), min_size_(std::min(min_size, capacity)) {}
   ~Pool();
 
   Pool() = delete;
@@ -47,9 +59,17 @@ public:
 
   Connection::Info GetConnection();
   void RestoreConnection(lcb_t connection);
+  // Destroys a connection that's no longer usable, the warmer replaces it
+  void DiscardConnection(lcb_t connection);
+
+  // Starts to create min_size connections in the background and keeps the
+  // pool at that size thereafter
+  void Warm();
 
 private:
   Connection::Info CreateConnection() const;
+  Connection::Info CreateConnectionTimed() const;
+  void KeepWarm();
   Connection::Info FormatErrorAndDestroyConn(const std::string &message,
                                              lcb_t connection,
                                              lcb_error_t error) const;
@@ -57,9 +77,15 @@ private:
   v8::Isolate *isolate_;
   std::string src_bucket_;
   const std::size_t capacity_;
+  const std::size_t min_size_;
   std::size_t current_size_{0};
+  // Connections being created, they're counted in current_size_ already
+  std::size_t pending_{0};
   std::queue<lcb_t> pool_;
   std::mutex pool_sync_;
+  std::condition_variable pool_cv_;
+  bool stop_warmer_{false};
+  std::thread warmer_thr_;
 };
 } // namespace Connection
 
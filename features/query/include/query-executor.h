@@ -0,0 +1,51 @@
+// Copyright (c) 2019 Couchbase, Inc.
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//     http://www.apache.org/licenses/LICENSE-2.0
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an "AS IS"
+// BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express
+// or implied. See the License for the specific language governing
+// permissions and limitations under the License.
+
+#ifndef QUERY_EXECUTOR_H
+#define QUERY_EXECUTOR_H
+
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <vector>
+
+namespace Query {
+// Long-lived threads which drive the queries of a worker, so that none is
+// spawned per query. A query holds on to its thread until it's done and the
+// nested ones must progress meanwhile, hence a thread is added whenever all
+// of them are busy. Their count is thus bounded by the connection pool size
+class Executor {
+public:
+  Executor() = default;
+  ~Executor();
+
+  Executor(Executor &&) = delete;
+  Executor(const Executor &) = delete;
+  Executor &operator=(Executor &&) = delete;
+  Executor &operator=(const Executor &) = delete;
+
+  void Submit(std::function<void()> task);
+
+private:
+  void Run();
+
+  std::queue<std::function<void()>> tasks_;
+  std::vector<std::thread> threads_;
+  std::size_t idle_{0};
+  bool stop_{false};
+  std::mutex sync_;
+  std::condition_variable signal_;
+};
+} // namespace Query
+
+#endif
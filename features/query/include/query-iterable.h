@@ -42,7 +42,8 @@ public:
 protected:
   enum InternalField {
     kIterator,
-    Count // Not a field
+    kBatchSize, // Rows per step of the iteration, 0 for one row at a time
+    Count       // Not a field
   };
 
   v8::Isolate *isolate_;
@@ -68,6 +69,7 @@ public:
 
 private:
   static void Impl(const v8::FunctionCallbackInfo<v8::Value> &args);
+  static void Batch(const v8::FunctionCallbackInfo<v8::Value> &args);
   static void Close(const v8::FunctionCallbackInfo<v8::Value> &args);
 };
 
@@ -80,6 +82,8 @@ public:
 
 private:
   static void Next(const v8::FunctionCallbackInfo<v8::Value> &args);
+  static void NextBatch(const v8::FunctionCallbackInfo<v8::Value> &args,
+                        Iterator *iterator, uint32_t batch_size);
 };
 
 class IterableResult {
@@ -101,8 +105,13 @@ public:
   IterableResult &operator=(const IterableResult &) = delete;
 
   IterableResult::Info NewObject(const Query::Row &row);
+  // batch is a JSON array of rows, parsed in one go
+  IterableResult::Info NewBatchObject(const std::string &batch, bool is_done);
 
 private:
+  IterableResult::Info NewObject(const std::string &data, bool is_done,
+                                 const char *what);
+
   v8::Isolate *isolate_;
   v8::Persistent<v8::Context> context_{};
   v8::Persistent<v8::ObjectTemplate> template_{};
@@ -12,11 +12,13 @@
 #ifndef QUERY_ITERATOR_H
 #define QUERY_ITERATOR_H
 
+#include <chrono>
 #include <condition_variable>
+#include <deque>
 #include <libcouchbase/couchbase.h>
 #include <libcouchbase/n1ql.h>
+#include <mutex>
 #include <string>
-#include <thread>
 #include <utility>
 #include <v8.h>
 
@@ -39,9 +41,7 @@ public:
     Iterator *iterator{nullptr};
   };
 
-  Iterator(Query::Info query_info, lcb_t instance, v8::Isolate *isolate)
-      : connection_(instance), isolate_(isolate),
-        builder_(isolate_, std::move(query_info), instance) {}
+  Iterator(Query::Info query_info, lcb_t instance, v8::Isolate *isolate);
   ~Iterator();
 
   Iterator() = delete;
@@ -60,43 +60,69 @@ private:
   static void RowCallback(lcb_t connection, int type, const lcb_RESPN1QL *resp);
   static bool IsStatusSuccess(const std::string &row);
 
+  // Runs on a thread of the Query::Executor
+  void Run();
+  // Drives the query to completion, cancels it as soon as the cursor is
+  // cancelled rather than upon its next row
+  lcb_error_t Drive();
+
+  // Rows are buffered by the SDK in a window bounded by both the count and
+  // the size of the rows, so that V8 only waits when it runs ahead of the
+  // query and the SDK only when V8 lags behind
   struct Cursor {
+    struct Entry {
+      lcb_error_t client_err_code{LCB_SUCCESS};
+      bool is_error{false};
+      bool is_client_auth_error{false};
+      bool is_client_error{false}; // Error reported by SDK client
+      std::string client_error;
+      bool is_query_error{false}; // Error reported by Query server
+      std::string query_error;
+      bool is_last{false};
+      std::string data;
+    };
+
+    Cursor(std::size_t max_rows, std::size_t max_bytes)
+        : max_rows_(max_rows), max_bytes_(max_bytes) {}
+
     Query::Row GetRow() const;
     Query::Row GetRowAsFinal() const;
 
-    enum class ExecutionControl { kV8, kSDK };
-
-    void WaitFor(ExecutionControl control);
-    void YieldTo(ExecutionControl control);
-
-    lcb_error_t client_err_code{LCB_SUCCESS};
-    bool is_error{false};
-    bool is_client_auth_error{false};
-    bool is_client_error{false}; // Error reported by SDK client
-    std::string client_error;
-    bool is_query_error{false}; // Error reported by Query server
-    std::string query_error;
-    bool is_last{false};
-    std::string data;
-
-  private:
-    ExecutionControl control_{ExecutionControl::kV8};
-    std::mutex control_sync_;
-    std::condition_variable control_signal_;
-  };
-
-  class RunnerGuard {
-  public:
-    explicit RunnerGuard(Cursor &cursor) : cursor_(cursor) {}
-    RunnerGuard() = delete;
-    RunnerGuard(const RunnerGuard &) = delete;
-    RunnerGuard(RunnerGuard &&) = delete;
-    RunnerGuard &operator=(const RunnerGuard &) = delete;
-    RunnerGuard &operator=(RunnerGuard &&) = delete;
-    ~RunnerGuard() { cursor_.YieldTo(Cursor::ExecutionControl::kV8); };
+    // Called by the SDK, blocks while the window is full. Returns false once
+    // the query is cancelled
+    bool Push(Entry entry);
+    // Called by V8, blocks until the next row is available and makes it the
+    // current one
+    void Pop();
+    // Drops the buffered rows and rejects the subsequent ones
+    void Cancel();
+    // Waits for at most timeout, returns true if the cursor is cancelled
+    bool WaitForCancel(std::chrono::milliseconds timeout);
+    // Called by the SDK once it's done with the query, ends the rows if the
+    // final one was never pushed
+    void Complete(::Info result);
+    ::Info WaitForCompletion();
+
+    // The row handed over to V8 last
+    Entry current;
 
   private:
-    Cursor &cursor_;
+    // A single row is let in regardless of its size
+    bool IsFull() const {
+      return !rows_.empty() &&
+             (rows_.size() >= max_rows_ || bytes_ >= max_bytes_);
+    }
+
+    const std::size_t max_rows_;
+    const std::size_t max_bytes_;
+    std::deque<Entry> rows_;
+    std::size_t bytes_{0};
+    bool is_final_pushed_{false};
+    bool is_cancelled_{false};
+    bool is_complete_{false};
+    ::Info result_{false};
+    std::mutex sync_;
+    std::condition_variable signal_;
   };
 
   enum class State { kIdle, kStarted, kStopped };
@@ -105,11 +131,13 @@ private:
   bool has_peeked_{false};
 
   lcb_t connection_;
-  ::Info result_info_{false};
+  // Only accessed on the executor thread
+  lcb_error_t final_err_code_{LCB_SUCCESS};
+  bool is_final_received_{false};
+  std::size_t rows_received_{0};
   v8::Isolate *isolate_;
   State state_{State::kIdle};
   Query::Builder builder_;
-  std::thread runner_;
 };
 } // namespace Query
 
@@ -12,12 +12,14 @@
 #ifndef QUERY_MGR_H
 #define QUERY_MGR_H
 
+#include <functional>
 #include <libcouchbase/couchbase.h>
 #include <string>
 #include <unordered_map>
 #include <v8.h>
 
 #include "conn-pool.h"
+#include "query-executor.h"
 #include "query-helper.h"
 #include "query-iterable.h"
 
@@ -25,8 +27,9 @@ namespace Query {
 class Manager {
 public:
   explicit Manager(v8::Isolate *isolate, const std::string &src_bucket,
-                   const std::size_t pool_size)
-      : isolate_(isolate), conn_pool_(pool_size, src_bucket, isolate) {}
+                   const std::size_t pool_size, const std::size_t min_pool_size)
+      : isolate_(isolate),
+        conn_pool_(pool_size, min_pool_size, src_bucket, isolate) {}
   ~Manager() { ClearQueries(); }
 
   Manager() = delete;
@@ -40,10 +43,19 @@ public:
   void RestoreConnection(lcb_t connection) {
     conn_pool_.RestoreConnection(connection);
   }
+  void DiscardConnection(lcb_t connection) {
+    conn_pool_.DiscardConnection(connection);
+  }
+  void WarmConnections() { conn_pool_.Warm(); }
+  void Execute(std::function<void()> task) {
+    executor_.Submit(std::move(task));
+  }
 
 private:
   v8::Isolate *isolate_;
   Connection::Pool conn_pool_;
+  // Destroyed ahead of conn_pool_ as its tasks return the connections
+  Executor executor_;
   std::unordered_map<lcb_t, std::unique_ptr<Iterator>> iterators_;
 };
 } // namespace Query
@@ -9,6 +9,7 @@
 // or implied. See the License for the specific language governing
 // permissions and limitations under the License.
 
+#include <chrono>
 #include <mutex>
 #include <sstream>
 
@@ -19,6 +20,26 @@
 #include "query-helper.h"
 #include "utils.h"
 
+std::atomic<int64_t> n1ql_conn_create_count = {0};
+std::atomic<int64_t> n1ql_conn_create_failure = {0};
+std::atomic<int64_t> n1ql_conn_create_time_us = {0};
+std::atomic<int64_t> n1ql_conn_discarded = {0};
+std::atomic<int64_t> n1ql_pool_wait_time_us = {0};
+
+Connection::Info Connection::Pool::CreateConnectionTimed() const {
+  const auto start = std::chrono::steady_clock::now();
+  auto info = CreateConnection();
+  n1ql_conn_create_time_us +=
+      std::chrono::duration_cast<std::chrono::microseconds>(
+          std::chrono::steady_clock::now() - start)
+          .count();
+  ++n1ql_conn_create_count;
+  if (info.is_fatal) {
+    ++n1ql_conn_create_failure;
+  }
+  return info;
+}
+
 Connection::Info Connection::Pool::CreateConnection() const {
   auto utils = UnwrapData(isolate_)->utils;
   auto conn_str_info = utils->GetConnectionString(src_bucket_);
@@ -87,23 +108,44 @@ Connection::Pool::FormatErrorAndDestroyConn(const std::string &message,
   auto info =
       Connection::Info{true, helper->ErrorFormat(message, connection, error)};
   lcb_destroy(connection);
+  auto comm = UnwrapData(isolate_)->comm;
+  if (error == LCB_AUTH_ERROR) {
+    comm->Refresh();
+  } else {
+    comm->RefreshKVNodes();
+  }
   return info;
 }
 
 Connection::Info Connection::Pool::GetConnection() {
-  std::lock_guard<std::mutex> lock(pool_sync_);
+  const auto start = std::chrono::steady_clock::now();
+  std::unique_lock<std::mutex> lock(pool_sync_);
+  // When the pool is full, a connection that's being created will be handed
+  // out as soon as it's ready
+  pool_cv_.wait(lock, [this] {
+    return !pool_.empty() || current_size_ < capacity_ || pending_ == 0;
+  });
+  n1ql_pool_wait_time_us +=
+      std::chrono::duration_cast<std::chrono::microseconds>(
+          std::chrono::steady_clock::now() - start)
+          .count();
 
   if (pool_.empty()) {
-    if (current_size_ < capacity_) {
-      if (auto info = CreateConnection(); info.is_fatal) {
-        return info;
-      } else {
-        pool_.push(info.connection);
-        ++current_size_;
-      }
-    } else {
+    if (current_size_ >= capacity_) {
       return {true, "Connection pool maximum capacity reached"};
     }
+
+    ++current_size_;
+    ++pending_;
+    lock.unlock();
+    auto info = CreateConnectionTimed();
+    lock.lock();
+    --pending_;
+    pool_cv_.notify_all();
+    if (info.is_fatal) {
+      --current_size_;
+    }
+    return info;
   }
 
   auto connection = pool_.front();
@@ -111,7 +153,54 @@ Connection::Info Connection::Pool::GetConnection() {
   return {connection};
 }
 
+void Connection::Pool::Warm() {
+  if (min_size_ == 0 || warmer_thr_.joinable()) {
+    return;
+  }
+  warmer_thr_ = std::thread(&Connection::Pool::KeepWarm, this);
+}
+
+void Connection::Pool::KeepWarm() {
+  std::unique_lock<std::mutex> lock(pool_sync_);
+  while (true) {
+    pool_cv_.wait(lock, [this] {
+      return stop_warmer_ || current_size_ < min_size_;
+    });
+    if (stop_warmer_) {
+      return;
+    }
+
+    ++current_size_;
+    ++pending_;
+    lock.unlock();
+    auto info = CreateConnectionTimed();
+    lock.lock();
+    --pending_;
+    if (info.is_fatal) {
+      --current_size_;
+      pool_cv_.notify_all();
+      LOG(logError) << "Unable to warm N1QL connection pool, err: "
+                    << info.msg << std::endl;
+      // Avoids hammering the cluster while it's unreachable
+      pool_cv_.wait_for(lock, std::chrono::seconds(1),
+                        [this] { return stop_warmer_; });
+      continue;
+    }
+    pool_.push(info.connection);
+    pool_cv_.notify_all();
+  }
+}
+
 Connection::Pool::~Pool() {
+  {
+    std::lock_guard<std::mutex> lock(pool_sync_);
+    stop_warmer_ = true;
+  }
+  pool_cv_.notify_all();
+  if (warmer_thr_.joinable()) {
+    warmer_thr_.join();
+  }
+
   while (!pool_.empty()) {
     lcb_destroy(pool_.front());
     pool_.pop();
@@ -121,4 +210,14 @@ Connection::Pool::~Pool() {
 void Connection::Pool::RestoreConnection(lcb_t connection) {
   std::lock_guard<std::mutex> lock(pool_sync_);
   pool_.push(connection);
+  pool_cv_.notify_all();
+}
+
+void Connection::Pool::DiscardConnection(lcb_t connection) {
+  lcb_destroy(connection);
+  ++n1ql_conn_discarded;
+
+  std::lock_guard<std::mutex> lock(pool_sync_);
+  --current_size_;
+  pool_cv_.notify_all();
 }
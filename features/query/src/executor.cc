@@ -0,0 +1,53 @@
+// Copyright (c) 2019 Couchbase, Inc.
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//     http://www.apache.org/licenses/LICENSE-2.0
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an "AS IS"
+// BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express
+// or implied. See the License for the specific language governing
+// permissions and limitations under the License.
+
+#include <utility>
+
+#include "query-executor.h"
+
+Query::Executor::~Executor() {
+  {
+    std::lock_guard<std::mutex> lock(sync_);
+    stop_ = true;
+  }
+  signal_.notify_all();
+  for (auto &thread : threads_) {
+    thread.join();
+  }
+}
+
+void Query::Executor::Submit(std::function<void()> task) {
+  std::lock_guard<std::mutex> lock(sync_);
+  tasks_.push(std::move(task));
+  if (idle_ < tasks_.size()) {
+    threads_.emplace_back(&Query::Executor::Run, this);
+    return;
+  }
+  signal_.notify_one();
+}
+
+void Query::Executor::Run() {
+  std::unique_lock<std::mutex> lock(sync_);
+  while (true) {
+    ++idle_;
+    signal_.wait(lock, [this] { return stop_ || !tasks_.empty(); });
+    --idle_;
+    if (tasks_.empty()) {
+      return;
+    }
+
+    auto task = std::move(tasks_.front());
+    tasks_.pop();
+    lock.unlock();
+    task();
+    lock.lock();
+  }
+}
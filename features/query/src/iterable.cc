@@ -41,6 +41,8 @@ Query::Iterable::Iterable(v8::Isolate *isolate,
   iterable_template->SetInternalFieldCount(InternalField::Count);
   iterable_template->Set(v8::Symbol::GetIterator(isolate_),
                          v8::FunctionTemplate::New(isolate_, Impl));
+  iterable_template->Set(v8Str(isolate_, "batch"),
+                         v8::FunctionTemplate::New(isolate_, Batch));
   iterable_template->Set(v8Str(isolate_, "close"),
                          v8::FunctionTemplate::New(isolate_, Close));
   template_.Reset(isolate_, iterable_template);
@@ -58,6 +60,8 @@ Query::IterableBase::Info Query::Iterable::NewObject(Iterator *iterator) const {
 
   iterable_obj->SetInternalField(InternalField::kIterator,
                                  v8::External::New(isolate_, iterator));
+  iterable_obj->SetInternalField(InternalField::kBatchSize,
+                                 v8::Integer::New(isolate_, 0));
   return {handle_scope.Escape(iterable_obj)};
 }
 
@@ -81,10 +85,33 @@ void Query::Iterable::Impl(const v8::FunctionCallbackInfo<v8::Value> &args) {
     js_exception->ThrowN1QLError(impl_info.msg);
     return;
   } else {
+    impl_info.object.As<v8::Object>()->SetInternalField(
+        InternalField::kBatchSize,
+        args.This()->GetInternalField(InternalField::kBatchSize));
     args.GetReturnValue().Set(impl_info.object);
   }
 }
 
+void Query::Iterable::Batch(const v8::FunctionCallbackInfo<v8::Value> &args) {
+  auto isolate = args.GetIsolate();
+  std::lock_guard<std::mutex> guard(UnwrapData(isolate)->termination_lock_);
+  if (!UnwrapData(isolate)->is_executing_) {
+    return;
+  }
+
+  v8::HandleScope handle_scope(isolate);
+  auto js_exception = UnwrapData(isolate)->js_exception;
+
+  if (args.Length() < 1 || !args[0]->IsUint32() ||
+      args[0].As<v8::Uint32>()->Value() == 0) {
+    js_exception->ThrowN1QLError("batch size must be a positive integer");
+    return;
+  }
+
+  args.This()->SetInternalField(InternalField::kBatchSize, args[0]);
+  args.GetReturnValue().Set(args.This());
+}
+
 void Query::Iterable::Close(const v8::FunctionCallbackInfo<v8::Value> &args) {
   auto isolate = args.GetIsolate();
   std::lock_guard<std::mutex> guard(UnwrapData(isolate)->termination_lock_);
@@ -123,6 +150,8 @@ Query::IterableImpl::NewObject(Iterator *iterator) const {
 
   result_obj->SetInternalField(InternalField::kIterator,
                                v8::External::New(isolate_, iterator));
+  result_obj->SetInternalField(InternalField::kBatchSize,
+                               v8::Integer::New(isolate_, 0));
   return {handle_scope.Escape(result_obj)};
 }
 
@@ -143,6 +172,12 @@ void Query::IterableImpl::Next(
   auto iterator =
       reinterpret_cast<Query::Iterator *>(iter_val.As<v8::External>()->Value());
 
+  auto batch_val = args.This()->GetInternalField(InternalField::kBatchSize);
+  if (auto batch_size = batch_val.As<v8::Uint32>()->Value(); batch_size > 0) {
+    NextBatch(args, iterator, batch_size);
+    return;
+  }
+
   auto next = iterator->Next();
   if (next.is_done || next.is_error) {
     // Error reported by lcb_wait (coming from LCB client)
@@ -168,6 +203,56 @@ void Query::IterableImpl::Next(
   }
 }
 
+// Rows are joined into a JSON array, so that V8 parses the whole batch at once
+void Query::IterableImpl::NextBatch(
+    const v8::FunctionCallbackInfo<v8::Value> &args, Iterator *iterator,
+    uint32_t batch_size) {
+  auto isolate = args.GetIsolate();
+  auto js_exception = UnwrapData(isolate)->js_exception;
+  auto helper = UnwrapData(isolate)->query_helper;
+  auto iterable_result = UnwrapData(isolate)->query_iterable_result;
+
+  std::string batch("[");
+  uint32_t count = 0;
+  auto is_done = false;
+  while (count < batch_size) {
+    auto next = iterator->Next();
+    if (next.is_done || next.is_error) {
+      if (auto it_result = iterator->Wait(); it_result.is_fatal) {
+        ++n1ql_op_exception_count;
+        js_exception->ThrowN1QLError(it_result.msg);
+        return;
+      }
+    }
+
+    if (next.is_error) {
+      helper->HandleRowError(next);
+      return;
+    }
+    if (next.is_done) {
+      is_done = true;
+      break;
+    }
+
+    if (count++ > 0) {
+      batch += ',';
+    }
+    batch += next.data;
+  }
+  batch += ']';
+
+  // The rows of the last, partial batch are handed out before done
+  if (auto result_info =
+          iterable_result->NewBatchObject(batch, is_done && count == 0);
+      result_info.is_fatal) {
+    ++n1ql_op_exception_count;
+    js_exception->ThrowN1QLError(result_info.msg);
+    return;
+  } else {
+    args.GetReturnValue().Set(result_info.result);
+  }
+}
+
 Query::IterableResult::IterableResult(v8::Isolate *isolate,
                                       const v8::Local<v8::Context> &context)
     : isolate_(isolate) {
@@ -183,6 +268,17 @@ Query::IterableResult::IterableResult(v8::Isolate *isolate,
 
 Query::IterableResult::Info
 Query::IterableResult::NewObject(const Query::Row &row) {
+  return NewObject(row.data, row.is_done, "query row");
+}
+
+Query::IterableResult::Info
+Query::IterableResult::NewBatchObject(const std::string &batch, bool is_done) {
+  return NewObject(batch, is_done, "query rows batch");
+}
+
+Query::IterableResult::Info
+Query::IterableResult::NewObject(const std::string &data, bool is_done,
+                                 const char *what) {
   v8::EscapableHandleScope handle_scope(isolate_);
   auto context = context_.Get(isolate_);
   auto result_template = template_.Get(isolate_);
@@ -194,28 +290,28 @@ Query::IterableResult::NewObject(const Query::Row &row) {
 
   auto result = false;
   if (!TO(result_obj->Set(context, v8Str(isolate_, "done"),
-                          v8::Boolean::New(isolate_, row.is_done)),
+                          v8::Boolean::New(isolate_, is_done)),
           &result) ||
       !result) {
     return {true, "Unable to set the value of done on iterable result object"};
   }
-  if (row.is_done) {
+  if (is_done) {
     return {handle_scope.Escape(result_obj)};
   }
 
   std::stringstream err_msg;
   v8::Local<v8::Value> value_val;
   // TODO : If JSON parse fails, try to provide (row, col) information
-  if (!TO_LOCAL(v8::JSON::Parse(isolate_, v8Str(isolate_, row.data)),
+  if (!TO_LOCAL(v8::JSON::Parse(isolate_, v8Str(isolate_, data)),
                 &value_val)) {
-    err_msg << "Unable to parse query row as JSON : " << RU(row.data);
+    err_msg << "Unable to parse " << what << " as JSON : " << RU(data);
     return {true, err_msg.str()};
   }
   result = false;
   if (!TO(result_obj->Set(context, v8Str(isolate_, "value"), value_val),
           &result)) {
     err_msg << "Unable to set value on iterable result object : "
-            << RU(row.data);
+            << RU(data);
     return {true, err_msg.str()};
   }
   return {handle_scope.Escape(result_obj)};
@@ -9,6 +9,7 @@
 // or implied. See the License for the specific language governing
 // permissions and limitations under the License.
 
+#include <algorithm>
 #include <libcouchbase/couchbase.h>
 #include <libcouchbase/n1ql.h>
 #include <memory>
@@ -16,23 +17,32 @@
 #include <regex>
 #include <sstream>
 #include <string>
-#include <thread>
 #include <utility>
 
+#include "bucket.h"
 #include "info.h"
 #include "isolate_data.h"
 #include "log.h"
 #include "query-iterator.h"
 #include "query-mgr.h"
 
-Query::Iterator::~Iterator() {
-  if (runner_.joinable()) {
-    runner_.join();
-  }
-}
+// How long the executor waits for a stop when the connection has nothing to
+// process
+constexpr std::chrono::milliseconds query_poll_interval{1};
+
+Query::Iterator::Iterator(Query::Info query_info, lcb_t instance,
+                          v8::Isolate *isolate)
+    : cursor_(static_cast<std::size_t>(
+                  std::max(UnwrapData(isolate)->n1ql_prefetch_rows, 1)),
+              static_cast<std::size_t>(
+                  std::max(UnwrapData(isolate)->n1ql_prefetch_bytes, 1))),
+      connection_(instance), isolate_(isolate),
+      builder_(isolate_, std::move(query_info), instance) {}
+
+Query::Iterator::~Iterator() { Stop(); }
 
 Query::Row Query::Iterator::Next() {
-  if (state_ != State::kStarted || cursor_.is_last) {
+  if (state_ != State::kStarted || cursor_.current.is_last) {
     return cursor_.GetRowAsFinal();
   }
   if (has_peeked_) {
@@ -40,8 +50,7 @@ Query::Row Query::Iterator::Next() {
     return cursor_.GetRow();
   }
 
-  cursor_.YieldTo(Cursor::ExecutionControl::kSDK);
-  cursor_.WaitFor(Cursor::ExecutionControl::kV8);
+  cursor_.Pop();
   return cursor_.GetRow();
 }
 
@@ -50,69 +59,114 @@ Query::Row Query::Iterator::Next() {
     return {true, "Unable to start query as it is not in idle state"};
   }
 
-  auto helper = UnwrapData(isolate_)->query_mgr;
-  if (auto info = builder_.Build(RowCallback, &cursor_); info.is_fatal) {
-    helper->RestoreConnection(connection_);
+  // The query may read what the handler has written so far
+  if (UnwrapData(isolate_)->pipeline_bucket_writes) {
+    FlushBucketWrites(isolate_);
+  }
+
+  auto query_mgr = UnwrapData(isolate_)->query_mgr;
+  if (auto info = builder_.Build(RowCallback, this); info.is_fatal) {
+    query_mgr->RestoreConnection(connection_);
     return info;
   }
 
-  cursor_.YieldTo(Cursor::ExecutionControl::kSDK);
-  std::thread runner([this]() -> void {
-    RunnerGuard guard(cursor_);
+  query_mgr->Execute([this]() -> void { Run(); });
+  state_ = State::kStarted;
+
+  cursor_.Pop();
+  has_peeked_ = true;
+  // Error reported by lcb_n1ql_query or lcb_wait, which ends the rows
+  if (cursor_.current.is_last) {
+    return cursor_.WaitForCompletion();
+  }
+  return {false};
+}
 
-    auto result = lcb_n1ql_query(connection_, nullptr, builder_.GetCmd());
-    if (result == LCB_SUCCESS) {
-      result = lcb_wait(connection_);
+void Query::Iterator::Run() {
+  ::Info info{false};
+  auto result = lcb_n1ql_query(connection_, nullptr, builder_.GetCmd());
+  if (result == LCB_SUCCESS) {
+    result = Drive();
+  }
+  if (result != LCB_SUCCESS) {
+    auto helper = UnwrapData(isolate_)->query_helper;
+    helper->AccountLCBError(static_cast<int>(result));
+    info = {true, lcb_strerror(connection_, result)};
+  }
+
+  auto query_mgr = UnwrapData(isolate_)->query_mgr;
+  if (LCB_EIFNET(result) || LCB_EIFNET(final_err_code_)) {
+    query_mgr->DiscardConnection(connection_);
+  } else {
+    query_mgr->RestoreConnection(connection_);
+  }
+  cursor_.Complete(std::move(info));
+}
+
+// lcb_wait can't be interrupted from V8's thread, so the connection is ticked
+// instead and the cursor is checked in between
+lcb_error_t Query::Iterator::Drive() {
+  while (!is_final_received_) {
+    const auto rows_received = rows_received_;
+    auto result = lcb_tick_nowait(connection_);
+    if (result == LCB_CLIENT_FEATURE_UNAVAILABLE) {
+      // The IO plugin can't tick, the query is cancelled upon its next row
+      return lcb_wait(connection_);
     }
     if (result != LCB_SUCCESS) {
-      cursor_.is_last = true;
-      auto helper = UnwrapData(isolate_)->query_helper;
-      helper->AccountLCBError(static_cast<int>(result));
-      result_info_ = {true, lcb_strerror(connection_, result)};
+      return result;
+    }
+    if (is_final_received_ || rows_received != rows_received_) {
+      continue;
     }
 
-    auto query_mgr = UnwrapData(isolate_)->query_mgr;
-    query_mgr->RestoreConnection(connection_);
-  });
-  runner_ = std::move(runner);
-
-  cursor_.WaitFor(Cursor::ExecutionControl::kV8);
-  has_peeked_ = true;
-  state_ = State::kStarted;
-  return result_info_;
+    if (cursor_.WaitForCancel(query_poll_interval)) {
+      lcb_n1ql_cancel(connection_, builder_.GetHandle());
+      break;
+    }
+  }
+  // Lets the SDK wrap up the request
+  return lcb_wait(connection_);
 }
 
 void Query::Iterator::RowCallback(lcb_t connection, int,
                                   const lcb_RESPN1QL *resp) {
-  auto cursor =
-      static_cast<Cursor *>(const_cast<void *>(lcb_get_cookie(connection)));
+  auto iterator =
+      static_cast<Iterator *>(const_cast<void *>(lcb_get_cookie(connection)));
 
-  cursor->data.assign(resp->row, resp->nrow);
-  cursor->is_last = (resp->rflags & LCB_RESP_F_FINAL) != 0;
-  cursor->client_err_code = resp->rc;
-  cursor->is_client_error = cursor->is_last && resp->rc != LCB_SUCCESS;
-  cursor->is_query_error = cursor->is_last && !IsStatusSuccess(cursor->data);
-  cursor->is_error = cursor->is_client_error || cursor->is_query_error;
-  cursor->is_client_auth_error =
-      cursor->is_error && (resp->rc == LCB_AUTH_ERROR);
+  Cursor::Entry row;
+  row.data.assign(resp->row, resp->nrow);
+  row.is_last = (resp->rflags & LCB_RESP_F_FINAL) != 0;
+  row.client_err_code = resp->rc;
+  row.is_client_error = row.is_last && resp->rc != LCB_SUCCESS;
+  row.is_query_error = row.is_last && !IsStatusSuccess(row.data);
+  row.is_error = row.is_client_error || row.is_query_error;
+  row.is_client_auth_error = row.is_error && (resp->rc == LCB_AUTH_ERROR);
 
-  if (cursor->is_client_error) {
-    cursor->client_error = lcb_strerror(connection, resp->rc);
+  if (row.is_client_error) {
+    row.client_error = lcb_strerror(connection, resp->rc);
   }
-  if (cursor->is_query_error) {
-    cursor->query_error = cursor->data;
+  if (row.is_query_error) {
+    row.query_error = row.data;
   }
 
-  LOG(logDebug) << "Query::Iterator::RowCallback data : " << RU(cursor->data)
-                << " is_last : " << cursor->is_last
-                << " is_error : " << cursor->is_error
-                << " is_client_auth_error : " << cursor->is_client_auth_error
+  LOG(logDebug) << "Query::Iterator::RowCallback data : " << RU(row.data)
+                << " is_last : " << row.is_last
+                << " is_error : " << row.is_error
+                << " is_client_auth_error : " << row.is_client_auth_error
                 << " resp rflags : " << resp->rflags
                 << " resp rc : " << resp->rc << std::endl;
 
-  cursor->YieldTo(Cursor::ExecutionControl::kV8);
-  if (!cursor->is_last) {
-    cursor->WaitFor(Cursor::ExecutionControl::kSDK);
+  ++iterator->rows_received_;
+  if (row.is_last) {
+    iterator->final_err_code_ = resp->rc;
+    iterator->is_final_received_ = true;
+  }
+  const auto is_last = row.is_last;
+  if (!iterator->cursor_.Push(std::move(row)) && !is_last) {
+    // Subsequent RowCallback won't be invoked
+    lcb_n1ql_cancel(connection, iterator->builder_.GetHandle());
+    iterator->is_final_received_ = true;
   }
 }
 
@@ -121,15 +175,10 @@ void Query::Iterator::Stop() {
     return;
   }
 
-  if (!cursor_.is_last) {
-    // Subsequent RowCallback won't be invoked
-    lcb_n1ql_cancel(connection_, builder_.GetHandle());
-    cursor_.YieldTo(Cursor::ExecutionControl::kSDK);
-  }
-
-  if (runner_.joinable()) {
-    runner_.join();
-  }
+  // The executor cancels the query, it can't be done from here as the
+  // executor may be within lcb_tick_nowait on the same connection
+  cursor_.Cancel();
+  cursor_.WaitForCompletion();
   state_ = State::kStopped;
 }
 
@@ -139,10 +188,10 @@ bool Query::Iterator::IsStatusSuccess(const std::string &row) {
 }
 
 ::Info Query::Iterator::Wait() {
-  if (runner_.joinable()) {
-    runner_.join();
+  if (state_ == State::kIdle) {
+    return {false};
   }
-  return result_info_;
+  return cursor_.WaitForCompletion();
 }
 
 Query::Row Query::Iterator::Peek() {
@@ -154,22 +203,74 @@ Query::Row Query::Iterator::Peek() {
   return row;
 }
 
-void Query::Iterator::Cursor::WaitFor(ExecutionControl control) {
-  std::unique_lock<std::mutex> lock(control_sync_);
-  control_signal_.wait(
-      lock, [this, &control]() -> bool { return control_ == control; });
+bool Query::Iterator::Cursor::Push(Entry entry) {
+  std::unique_lock<std::mutex> lock(sync_);
+  signal_.wait(lock, [this]() -> bool { return is_cancelled_ || !IsFull(); });
+  if (is_cancelled_) {
+    return false;
+  }
+
+  is_final_pushed_ = entry.is_last;
+  bytes_ += entry.data.size();
+  rows_.emplace_back(std::move(entry));
+  // V8 waits only on an empty window
+  if (rows_.size() == 1) {
+    signal_.notify_all();
+  }
+  return true;
+}
+
+void Query::Iterator::Cursor::Pop() {
+  std::unique_lock<std::mutex> lock(sync_);
+  signal_.wait(lock, [this]() -> bool { return !rows_.empty(); });
+  // The SDK waits only on a full window
+  const auto was_full = IsFull();
+  current = std::move(rows_.front());
+  rows_.pop_front();
+  bytes_ -= current.data.size();
+  if (was_full) {
+    signal_.notify_all();
+  }
+}
+
+void Query::Iterator::Cursor::Cancel() {
+  std::lock_guard<std::mutex> lock(sync_);
+  is_cancelled_ = true;
+  rows_.clear();
+  bytes_ = 0;
+  signal_.notify_all();
+}
+
+void Query::Iterator::Cursor::Complete(::Info result) {
+  std::lock_guard<std::mutex> lock(sync_);
+  if (!is_final_pushed_ && !is_cancelled_) {
+    Entry final_row;
+    final_row.is_last = true;
+    rows_.emplace_back(std::move(final_row));
+  }
+  result_ = std::move(result);
+  is_complete_ = true;
+  signal_.notify_all();
+}
+
+bool Query::Iterator::Cursor::WaitForCancel(std::chrono::milliseconds timeout) {
+  std::unique_lock<std::mutex> lock(sync_);
+  return signal_.wait_for(lock, timeout,
+                          [this]() -> bool { return is_cancelled_; });
 }
 
-void Query::Iterator::Cursor::YieldTo(const ExecutionControl control) {
-  std::lock_guard<std::mutex> lock(control_sync_);
-  control_ = control;
-  control_signal_.notify_one();
+::Info Query::Iterator::Cursor::WaitForCompletion() {
+  std::unique_lock<std::mutex> lock(sync_);
+  signal_.wait(lock, [this]() -> bool { return is_complete_; });
+  return result_;
 }
 
 Query::Row Query::Iterator::Cursor::GetRow() const {
-  return {is_last,         is_error,        is_client_auth_error,
-          is_client_error, client_error,    is_query_error,
-          query_error,     client_err_code, data};
+  return {current.is_last,              current.is_error,
+          current.is_client_auth_error, current.is_client_error,
+          current.client_error,         current.is_query_error,
+          current.query_error,          current.client_err_code,
+          current.data};
 }
 
 Query::Row Query::Iterator::Cursor::GetRowAsFinal() const {
@@ -10,14 +10,17 @@
 // permissions and limitations under the License.
 
 #include <algorithm>
+#include <chrono>
 #include <memory>
 #include <mutex>
 #include <ostream>
 #include <sstream>
 #include <string>
+#include <unordered_map>
 #include <utility>
 
 #include "bucket.h"
+#include "comm.h"
 #include "error.h"
 #include "js_exception.h"
 #include "lang_compat.h"
@@ -28,6 +31,16 @@
 
 std::atomic<int64_t> bucket_op_exception_count = {0};
 std::atomic<int64_t> lcb_retry_failure = {0};
+std::atomic<int64_t> bucket_op_pipelined_writes = {0};
+
+// Bounds the memory held by the cookies of the pending writes
+constexpr std::size_t max_pending_writes = 512;
+
+constexpr char function_instance_id_path[] = "_eventing.fiid";
+constexpr char dcp_seqno_path[] = "_eventing.seqno";
+constexpr char dcp_seqno_macro[] = R"("${Mutation.seqno}")";
+constexpr char value_crc32_path[] = "_eventing.crc";
+constexpr char value_crc32_macro[] = R"("${Mutation.value_crc32c}")";
 
 BucketFactory::BucketFactory(v8::Isolate *isolate,
                              const v8::Local<v8::Context> &context)
@@ -152,8 +165,9 @@ Error Bucket::Connect() {
                         SubDocumentCallback);
   lcb_install_callback3(connection_, LCB_CALLBACK_REMOVE, DeleteCallback);
 
-  // TODO : Need to make timeout configurable
-  lcb_U32 lcb_timeout = 2500000; // 2.5s
+  const auto isolate_data = UnwrapData(isolate_);
+  lcb_U32 lcb_timeout =
+      static_cast<lcb_U32>(isolate_data->bucket_op_timeout) * 1000; // us
   result =
       RetryWithFixedBackoff(5, 200, IsRetriable, lcb_cntl, connection_,
                             LCB_CNTL_SET, LCB_CNTL_OP_TIMEOUT, &lcb_timeout);
@@ -170,17 +184,222 @@ Error Bucket::Connect() {
     return FormatErrorAndDestroyConn("Unable to set detailed error codes",
                                      result);
   }
+  xattr_specs_ =
+      std::make_shared<XattrSpecs>(GetFunctionInstanceID(isolate_));
+
+  if (isolate_data->bucket_cache_size > 0) {
+    cache_ = std::make_shared<BucketCache>(
+        isolate_data->bucket_cache_size,
+        std::chrono::milliseconds(isolate_data->bucket_cache_age));
+  }
+
   LOG(logTrace) << __func__ << " connected to bucket " << RU(bucket_name_)
                 << " successfully" << std::endl;
   is_connected_ = true;
   return nullptr;
 }
 
+Bucket::XattrSpecs::XattrSpecs(std::string function_instance_id)
+    : function_instance_id_(std::move(function_instance_id)) {
+  InitXattrSpecs(set_specs_);
+  auto &set_doc_spec = set_specs_.back();
+  set_doc_spec.sdcmd = LCB_SDCMD_SET_FULLDOC;
+  LCB_SDSPEC_SET_PATH(&set_doc_spec, "", 0);
+
+  InitXattrSpecs(delete_specs_);
+  auto &delete_doc_spec = delete_specs_.back();
+  delete_doc_spec.sdcmd = LCB_SDCMD_REMOVE_FULLDOC;
+  LCB_SDSPEC_SET_PATH(&delete_doc_spec, "", 0);
+  LCB_SDSPEC_SET_VALUE(&delete_doc_spec, "", 0);
+}
+
+// lcb copies the values of the specs while scheduling, so patching them in
+// place is safe
+lcb_SDSPEC *Bucket::XattrSpecs::ForSet(const std::string &value) {
+  LCB_SDSPEC_SET_VALUE(&set_specs_.back(), value.c_str(), value.length());
+  return set_specs_.data();
+}
+
+void Bucket::XattrSpecs::InitXattrSpecs(
+    std::array<lcb_SDSPEC, num_specs> &specs) const {
+  specs.fill({0});
+
+  auto &function_id_spec = specs[0];
+  function_id_spec.sdcmd = LCB_SDCMD_DICT_UPSERT;
+  function_id_spec.options =
+      LCB_SDSPEC_F_MKINTERMEDIATES | LCB_SDSPEC_F_XATTRPATH;
+  LCB_SDSPEC_SET_PATH(&function_id_spec, function_instance_id_path,
+                      sizeof(function_instance_id_path) - 1);
+  LCB_SDSPEC_SET_VALUE(&function_id_spec, function_instance_id_.c_str(),
+                       function_instance_id_.size());
+
+  auto &dcp_seqno_spec = specs[1];
+  dcp_seqno_spec.sdcmd = LCB_SDCMD_DICT_UPSERT;
+  dcp_seqno_spec.options =
+      LCB_SDSPEC_F_MKINTERMEDIATES | LCB_SDSPEC_F_XATTR_MACROVALUES;
+  LCB_SDSPEC_SET_PATH(&dcp_seqno_spec, dcp_seqno_path,
+                      sizeof(dcp_seqno_path) - 1);
+  LCB_SDSPEC_SET_VALUE(&dcp_seqno_spec, dcp_seqno_macro,
+                       sizeof(dcp_seqno_macro) - 1);
+
+  auto &value_crc32_spec = specs[2];
+  value_crc32_spec.sdcmd = LCB_SDCMD_DICT_UPSERT;
+  value_crc32_spec.options =
+      LCB_SDSPEC_F_MKINTERMEDIATES | LCB_SDSPEC_F_XATTR_MACROVALUES;
+  LCB_SDSPEC_SET_PATH(&value_crc32_spec, value_crc32_path,
+                      sizeof(value_crc32_path) - 1);
+  LCB_SDSPEC_SET_VALUE(&value_crc32_spec, value_crc32_macro,
+                       sizeof(value_crc32_macro) - 1);
+}
+
+// A retry mustn't outlive the execution budget of the handler that issued it
+std::chrono::steady_clock::time_point Bucket::GetRetryDeadline() const {
+  return std::chrono::steady_clock::now() + GetRemainingExecutionTime(isolate_);
+}
+
+bool Bucket::IsPipelined() const {
+  return UnwrapData(isolate_)->pipeline_bucket_writes;
+}
+
+bool Bucket::ScheduleWrite(const std::string &key, bool is_delete,
+                           std::function<lcb_error_t(Result *)> schedule) {
+  if (pending_writes_.size() >= max_pending_writes) {
+    FlushPendingWrites();
+  }
+
+  // lcb copies the key and value while scheduling, only the cookie needs to
+  // outlive this call
+  pending_writes_.push_back({key, is_delete, Result(), std::move(schedule)});
+  auto &pending_write = pending_writes_.back();
+  lcb_sched_enter(connection_);
+  auto err = pending_write.schedule(&pending_write.result);
+  if (err != LCB_SUCCESS) {
+    lcb_sched_fail(connection_);
+    pending_writes_.pop_back();
+    LOG(logTrace) << "Bucket: Unable to schedule pipelined write: "
+                  << lcb_strerror(connection_, err) << std::endl;
+    return false;
+  }
+  lcb_sched_leave(connection_);
+  ++bucket_op_pipelined_writes;
+  return true;
+}
+
+void Bucket::RescheduleFailedWrites() {
+  for (auto &pending_write : pending_writes_) {
+    pending_write.result = Result();
+    lcb_sched_enter(connection_);
+    auto err = pending_write.schedule(&pending_write.result);
+    if (err != LCB_SUCCESS) {
+      lcb_sched_fail(connection_);
+      pending_write.result.rc = err;
+      continue;
+    }
+    lcb_sched_leave(connection_);
+  }
+}
+
+lcb_error_t Bucket::ScheduleGets(const std::vector<std::string> &keys,
+                                 std::vector<Result> &results) {
+  lcb_sched_enter(connection_);
+  for (std::size_t i = 0; i < keys.size(); ++i) {
+    lcb_CMDGET cmd = {0};
+    LCB_CMD_SET_KEY(&cmd, keys[i].c_str(), keys[i].length());
+    auto err = lcb_get3(connection_, &results[i], &cmd);
+    if (err != LCB_SUCCESS) {
+      lcb_sched_fail(connection_);
+      LOG(logTrace) << "Bucket: Unable to set params for LCB_GET: "
+                    << lcb_strerror(connection_, err) << std::endl;
+      return err;
+    }
+  }
+  lcb_sched_leave(connection_);
+  return LCB_SUCCESS;
+}
+
+// Retriable failures are scheduled again for as long as the execution budget
+// of the handler allows
+void Bucket::FlushPendingWrites() {
+  if (pending_writes_.empty()) {
+    return;
+  }
+
+  const auto max_retry = UnwrapData(isolate_)->lcb_retry_count;
+  auto is_retry = false;
+  RetryLcbOperation(max_retry, GetRetryDeadline(), IsRetriable, [&]() {
+    if (is_retry) {
+      RescheduleFailedWrites();
+    }
+    is_retry = true;
+
+    auto err = lcb_wait(connection_);
+    if (err != LCB_SUCCESS) {
+      LOG(logError) << "Bucket: Unable to flush pipelined writes: "
+                    << lcb_strerror(connection_, err) << std::endl;
+    }
+    CompletePendingWrites();
+    return pending_writes_.empty() ? LCB_SUCCESS
+                                   : pending_writes_.front().result.rc;
+  });
+
+  for (const auto &pending_write : pending_writes_) {
+    ++lcb_retry_failure;
+    FailPendingWrite(pending_write);
+  }
+  pending_writes_.clear();
+}
+
+// The handler has moved on by the time the result of a pipelined write is
+// known, so failures are accounted for instead of being thrown. Only the last
+// write to a key decides its value, so an earlier one isn't retried over it
+void Bucket::CompletePendingWrites() {
+  const auto has_retriable =
+      std::any_of(pending_writes_.begin(), pending_writes_.end(),
+                  [](const PendingWrite &pending_write) {
+                    return IsRetriable(pending_write.result.rc);
+                  });
+  std::unordered_map<std::string, std::size_t> writes_per_key;
+  if (has_retriable) {
+    for (const auto &pending_write : pending_writes_) {
+      ++writes_per_key[pending_write.key];
+    }
+  }
+
+  for (auto it = pending_writes_.begin(); it != pending_writes_.end();) {
+    const auto rc = it->result.rc;
+    const auto is_last_write = has_retriable && --writes_per_key[it->key] == 0;
+    if (IsRetriable(rc) && is_last_write) {
+      ++it;
+      continue;
+    }
+    if (rc != LCB_SUCCESS && !(it->is_delete && rc == LCB_KEY_ENOENT) &&
+        !IsRetriable(rc)) {
+      FailPendingWrite(*it);
+    }
+    it = pending_writes_.erase(it);
+  }
+}
+
+void Bucket::FailPendingWrite(const PendingWrite &pending_write) {
+  const auto rc = pending_write.result.rc;
+  AddLcbException(UnwrapData(isolate_), rc);
+  ++bucket_op_exception_count;
+  LOG(logError) << "Bucket: Pipelined write to key: " << RU(pending_write.key)
+                << " failed, err: " << lcb_strerror(connection_, rc)
+                << std::endl;
+}
+
 Error Bucket::FormatErrorAndDestroyConn(const std::string &message,
                                         const lcb_error_t &error) const {
   std::stringstream err_msg;
   err_msg << message << ", err: " << lcb_strerror(connection_, error);
   lcb_destroy(connection_);
+  auto comm = UnwrapData(isolate_)->comm;
+  if (error == LCB_AUTH_ERROR) {
+    comm->Refresh();
+  } else {
+    comm->RefreshKVNodes();
+  }
   LOG(logError) << __func__ << " " << err_msg.str() << std::endl;
   return std::make_unique<std::string>(err_msg.str());
 }
@@ -191,76 +410,107 @@ Bucket::Get(const std::string &key) {
     return {std::make_unique<std::string>("Connection is not initialized"),
             nullptr, nullptr};
   }
+  if (IsPipelined()) {
+    FlushBucketWrites(isolate_, this);
+  }
+
+  if (cache_ != nullptr) {
+    if (auto entry = cache_->Get(key); entry != nullptr) {
+      auto result = std::make_unique<Result>();
+      result->value = entry->value;
+      result->cas = entry->cas;
+      return {nullptr, std::make_unique<lcb_error_t>(LCB_SUCCESS),
+              std::move(result)};
+    }
+  }
 
   lcb_CMDGET cmd = {0};
   LCB_CMD_SET_KEY(&cmd, key.c_str(), key.length());
   const auto max_retry = UnwrapData(isolate_)->lcb_retry_count;
+  const auto deadline = GetRetryDeadline();
+  // Pending writes go out in the same round trip, ahead of the read on the
+  // connection, so the read observes them
   auto [err_code, result] =
-      RetryLcbCommand(connection_, cmd, max_retry, LcbGet);
+      RetryLcbCommand(connection_, cmd, max_retry, deadline, LcbGet);
+  CompletePendingWrites();
   if (err_code != LCB_SUCCESS) {
     ++lcb_retry_failure;
     return {nullptr, std::make_unique<lcb_error_t>(err_code), nullptr};
   }
+  if (cache_ != nullptr && result.rc == LCB_SUCCESS) {
+    cache_->Put(key, result.value, result.cas);
+  }
   return {nullptr, std::make_unique<lcb_error_t>(err_code),
           std::make_unique<Result>(std::move(result))};
 }
 
+std::tuple<Error, std::unique_ptr<lcb_error_t>,
+           std::unique_ptr<std::vector<Result>>>
+Bucket::GetMulti(const std::vector<std::string> &keys) {
+  if (!is_connected_) {
+    return {std::make_unique<std::string>("Connection is not initialized"),
+            nullptr, nullptr};
+  }
+  if (IsPipelined()) {
+    FlushBucketWrites(isolate_, this);
+  }
+
+  const auto max_retry = UnwrapData(isolate_)->lcb_retry_count;
+  auto results = std::make_unique<std::vector<Result>>();
+  auto err_code =
+      RetryLcbOperation(max_retry, GetRetryDeadline(), IsRetriable, [&]() {
+        results->assign(keys.size(), Result());
+        auto err_code = ScheduleGets(keys, *results);
+        if (err_code == LCB_SUCCESS) {
+          err_code = lcb_wait(connection_);
+          CompletePendingWrites();
+        }
+        return err_code;
+      });
+
+  if (err_code != LCB_SUCCESS) {
+    ++lcb_retry_failure;
+    return {nullptr, std::make_unique<lcb_error_t>(err_code), nullptr};
+  }
+  return {nullptr, std::make_unique<lcb_error_t>(err_code),
+          std::move(results)};
+}
+
 std::tuple<Error, std::unique_ptr<lcb_error_t>, std::unique_ptr<Result>>
 Bucket::SetWithXattr(const std::string &key, const std::string &value) {
   if (!is_connected_) {
     return {std::make_unique<std::string>("Connection is not initialized"),
             nullptr, nullptr};
   }
+  if (cache_ != nullptr) {
+    cache_->Invalidate(key);
+  }
 
-  lcb_SDSPEC function_id_spec = {0};
-  auto function_instance_id = GetFunctionInstanceID(isolate_);
-  std::string function_instance_id_path("_eventing.fiid");
-  function_id_spec.sdcmd = LCB_SDCMD_DICT_UPSERT;
-  function_id_spec.options =
-      LCB_SDSPEC_F_MKINTERMEDIATES | LCB_SDSPEC_F_XATTRPATH;
-  LCB_SDSPEC_SET_PATH(&function_id_spec, function_instance_id_path.c_str(),
-                      function_instance_id_path.size());
-  LCB_SDSPEC_SET_VALUE(&function_id_spec, function_instance_id.c_str(),
-                       function_instance_id.size());
-
-  lcb_SDSPEC dcp_seqno_spec = {0};
-  std::string dcp_seqno_path("_eventing.seqno");
-  std::string dcp_seqno_macro(R"("${Mutation.seqno}")");
-  dcp_seqno_spec.sdcmd = LCB_SDCMD_DICT_UPSERT;
-  dcp_seqno_spec.options =
-      LCB_SDSPEC_F_MKINTERMEDIATES | LCB_SDSPEC_F_XATTR_MACROVALUES;
-  LCB_SDSPEC_SET_PATH(&dcp_seqno_spec, dcp_seqno_path.c_str(),
-                      dcp_seqno_path.size());
-  LCB_SDSPEC_SET_VALUE(&dcp_seqno_spec, dcp_seqno_macro.c_str(),
-                       dcp_seqno_macro.size());
-
-  lcb_SDSPEC value_crc32_spec = {0};
-  std::string value_crc32_path("_eventing.crc");
-  std::string value_crc32_macro(R"("${Mutation.value_crc32c}")");
-  value_crc32_spec.sdcmd = LCB_SDCMD_DICT_UPSERT;
-  value_crc32_spec.options =
-      LCB_SDSPEC_F_MKINTERMEDIATES | LCB_SDSPEC_F_XATTR_MACROVALUES;
-  LCB_SDSPEC_SET_PATH(&value_crc32_spec, value_crc32_path.c_str(),
-                      value_crc32_path.size());
-  LCB_SDSPEC_SET_VALUE(&value_crc32_spec, value_crc32_macro.c_str(),
-                       value_crc32_macro.size());
-
-  lcb_SDSPEC doc_spec = {0};
-  doc_spec.sdcmd = LCB_SDCMD_SET_FULLDOC;
-  LCB_SDSPEC_SET_PATH(&doc_spec, "", 0);
-  LCB_SDSPEC_SET_VALUE(&doc_spec, value.c_str(), value.length());
-
-  std::vector<lcb_SDSPEC> specs = {function_id_spec, dcp_seqno_spec,
-                                   value_crc32_spec, doc_spec};
   lcb_CMDSUBDOC cmd = {0};
   LCB_CMD_SET_KEY(&cmd, key.c_str(), key.length());
-  cmd.specs = specs.data();
-  cmd.nspecs = specs.size();
+  cmd.specs = xattr_specs_->ForSet(value);
+  cmd.nspecs = XattrSpecs::num_specs;
   cmd.cmdflags = LCB_CMDSUBDOC_F_UPSERT_DOC;
 
+  if (IsPipelined()) {
+    // Rebinds the command to copies owned by the pending write, so that the
+    // write can be scheduled again
+    auto schedule = [this, cmd, key, value](Result *cookie) mutable {
+      LCB_CMD_SET_KEY(&cmd, key.c_str(), key.length());
+      cmd.specs = xattr_specs_->ForSet(value);
+      return lcb_subdoc3(connection_, cookie, &cmd);
+    };
+    if (ScheduleWrite(key, false, std::move(schedule))) {
+      return {nullptr, std::make_unique<lcb_error_t>(LCB_SUCCESS),
+              std::make_unique<Result>()};
+    }
+  }
+
   const auto max_retry = UnwrapData(isolate_)->lcb_retry_count;
+  const auto deadline = GetRetryDeadline();
   auto [err_code, result] =
-      RetryLcbCommand(connection_, cmd, max_retry, LcbSubdocSet);
+      RetryLcbCommand(connection_, cmd, max_retry, deadline, LcbSubdocSet);
+  CompletePendingWrites();
   if (err_code != LCB_SUCCESS) {
     ++lcb_retry_failure;
     return {nullptr, std::make_unique<lcb_error_t>(err_code), nullptr};
@@ -275,6 +525,9 @@ Bucket::SetWithoutXattr(const std::string &key, const std::string &value) {
     return {std::make_unique<std::string>("Connection is not initialized"),
             nullptr, nullptr};
   }
+  if (cache_ != nullptr) {
+    cache_->Invalidate(key);
+  }
 
   lcb_CMDSTORE cmd = {0};
   LCB_CMD_SET_KEY(&cmd, key.c_str(), key.length());
@@ -282,9 +535,23 @@ Bucket::SetWithoutXattr(const std::string &key, const std::string &value) {
   cmd.operation = LCB_SET;
   cmd.flags = 0x2000000;
 
+  if (IsPipelined()) {
+    auto schedule = [this, cmd, key, value](Result *cookie) mutable {
+      LCB_CMD_SET_KEY(&cmd, key.c_str(), key.length());
+      LCB_CMD_SET_VALUE(&cmd, value.c_str(), value.length());
+      return lcb_store3(connection_, cookie, &cmd);
+    };
+    if (ScheduleWrite(key, false, std::move(schedule))) {
+      return {nullptr, std::make_unique<lcb_error_t>(LCB_SUCCESS),
+              std::make_unique<Result>()};
+    }
+  }
+
   const auto max_retry = UnwrapData(isolate_)->lcb_retry_count;
+  const auto deadline = GetRetryDeadline();
   auto [err_code, result] =
-      RetryLcbCommand(connection_, cmd, max_retry, LcbSet);
+      RetryLcbCommand(connection_, cmd, max_retry, deadline, LcbSet);
+  CompletePendingWrites();
   if (err_code != LCB_SUCCESS) {
     ++lcb_retry_failure;
     return {nullptr, std::make_unique<lcb_error_t>(err_code), nullptr};
@@ -299,55 +566,32 @@ Bucket::DeleteWithXattr(const std::string &key) {
     return {std::make_unique<std::string>("Connection is not initialized"),
             nullptr, nullptr};
   }
+  if (cache_ != nullptr) {
+    cache_->Invalidate(key);
+  }
 
-  lcb_SDSPEC function_id_spec = {0};
-  std::string function_instance_id = GetFunctionInstanceID(isolate_);
-  std::string function_instance_id_path("_eventing.fiid");
-  function_id_spec.sdcmd = LCB_SDCMD_DICT_UPSERT;
-  function_id_spec.options =
-      LCB_SDSPEC_F_MKINTERMEDIATES | LCB_SDSPEC_F_XATTRPATH;
-  LCB_SDSPEC_SET_PATH(&function_id_spec, function_instance_id_path.c_str(),
-                      function_instance_id_path.size());
-  LCB_SDSPEC_SET_VALUE(&function_id_spec, function_instance_id.c_str(),
-                       function_instance_id.size());
-
-  lcb_SDSPEC dcp_seqno_spec = {0};
-  std::string dcp_seqno_path("_eventing.seqno");
-  std::string dcp_seqno_macro(R"("${Mutation.seqno}")");
-  dcp_seqno_spec.sdcmd = LCB_SDCMD_DICT_UPSERT;
-  dcp_seqno_spec.options =
-      LCB_SDSPEC_F_MKINTERMEDIATES | LCB_SDSPEC_F_XATTR_MACROVALUES;
-  LCB_SDSPEC_SET_PATH(&dcp_seqno_spec, dcp_seqno_path.c_str(),
-                      dcp_seqno_path.size());
-  LCB_SDSPEC_SET_VALUE(&dcp_seqno_spec, dcp_seqno_macro.c_str(),
-                       dcp_seqno_macro.size());
-
-  lcb_SDSPEC value_crc32_spec = {0};
-  std::string value_crc32_path("_eventing.crc");
-  std::string value_crc32_macro(R"("${Mutation.value_crc32c}")");
-  value_crc32_spec.sdcmd = LCB_SDCMD_DICT_UPSERT;
-  value_crc32_spec.options =
-      LCB_SDSPEC_F_MKINTERMEDIATES | LCB_SDSPEC_F_XATTR_MACROVALUES;
-  LCB_SDSPEC_SET_PATH(&value_crc32_spec, value_crc32_path.c_str(),
-                      value_crc32_path.size());
-  LCB_SDSPEC_SET_VALUE(&value_crc32_spec, value_crc32_macro.c_str(),
-                       value_crc32_macro.size());
-
-  lcb_SDSPEC doc_spec = {0};
-  doc_spec.sdcmd = LCB_SDCMD_REMOVE_FULLDOC;
-  LCB_SDSPEC_SET_PATH(&doc_spec, "", 0);
-  LCB_SDSPEC_SET_VALUE(&doc_spec, "", 0);
-
-  std::vector<lcb_SDSPEC> specs = {function_id_spec, dcp_seqno_spec,
-                                   value_crc32_spec, doc_spec};
   lcb_CMDSUBDOC cmd = {0};
   LCB_CMD_SET_KEY(&cmd, key.c_str(), key.length());
-  cmd.specs = specs.data();
-  cmd.nspecs = specs.size();
+  cmd.specs = xattr_specs_->ForDelete();
+  cmd.nspecs = XattrSpecs::num_specs;
+
+  if (IsPipelined()) {
+    auto schedule = [this, cmd, key](Result *cookie) mutable {
+      LCB_CMD_SET_KEY(&cmd, key.c_str(), key.length());
+      cmd.specs = xattr_specs_->ForDelete();
+      return lcb_subdoc3(connection_, cookie, &cmd);
+    };
+    if (ScheduleWrite(key, true, std::move(schedule))) {
+      return {nullptr, std::make_unique<lcb_error_t>(LCB_SUCCESS),
+              std::make_unique<Result>()};
+    }
+  }
 
   const auto max_retry = UnwrapData(isolate_)->lcb_retry_count;
+  const auto deadline = GetRetryDeadline();
   auto [err_code, result] =
-      RetryLcbCommand(connection_, cmd, max_retry, LcbSubdocDelete);
+      RetryLcbCommand(connection_, cmd, max_retry, deadline, LcbSubdocDelete);
+  CompletePendingWrites();
   if (err_code != LCB_SUCCESS) {
     ++lcb_retry_failure;
     return {nullptr, std::make_unique<lcb_error_t>(err_code), nullptr};
@@ -362,13 +606,29 @@ Bucket::DeleteWithoutXattr(const std::string &key) {
     return {std::make_unique<std::string>("Connection is not initialized"),
             nullptr, nullptr};
   }
+  if (cache_ != nullptr) {
+    cache_->Invalidate(key);
+  }
 
   lcb_CMDREMOVE cmd = {0};
   LCB_CMD_SET_KEY(&cmd, key.c_str(), key.length());
 
+  if (IsPipelined()) {
+    auto schedule = [this, cmd, key](Result *cookie) mutable {
+      LCB_CMD_SET_KEY(&cmd, key.c_str(), key.length());
+      return lcb_remove3(connection_, cookie, &cmd);
+    };
+    if (ScheduleWrite(key, true, std::move(schedule))) {
+      return {nullptr, std::make_unique<lcb_error_t>(LCB_SUCCESS),
+              std::make_unique<Result>()};
+    }
+  }
+
   const auto max_retry = UnwrapData(isolate_)->lcb_retry_count;
+  const auto deadline = GetRetryDeadline();
   auto [err_code, result] =
-      RetryLcbCommand(connection_, cmd, max_retry, LcbDelete);
+      RetryLcbCommand(connection_, cmd, max_retry, deadline, LcbDelete);
+  CompletePendingWrites();
   if (err_code != LCB_SUCCESS) {
     ++lcb_retry_failure;
     return {nullptr, std::make_unique<lcb_error_t>(err_code), nullptr};
@@ -423,10 +683,21 @@ void BucketBinding::BucketGet<v8::Local<v8::Name>>(
     return;
   }
 
+  auto parsed_doc_cache = UnwrapInternalField<ParsedDocCache>(
+      info.Holder(), InternalFields::kParsedDocCache);
   v8::Local<v8::Value> value_json;
+  if (parsed_doc_cache != nullptr &&
+      parsed_doc_cache->Get(key, result->cas, &value_json)) {
+    info.GetReturnValue().Set(value_json);
+    return;
+  }
+
   TO_LOCAL(v8::JSON::Parse(context, v8Str(isolate, result->value)),
            &value_json);
   // TODO : Log here or throw exception if JSON parse fails
+  if (parsed_doc_cache != nullptr && !value_json.IsEmpty()) {
+    parsed_doc_cache->Put(context, key, result->cas, value_json);
+  }
   info.GetReturnValue().Set(value_json);
 }
 
@@ -538,6 +809,97 @@ void BucketBinding::BucketDelete<v8::Local<v8::Name>>(
   info.GetReturnValue().Set(true);
 }
 
+void BucketBinding::GetMulti(const v8::FunctionCallbackInfo<v8::Value> &args) {
+  auto isolate = args.GetIsolate();
+  auto isolate_data = UnwrapData(isolate);
+  auto js_exception = isolate_data->js_exception;
+  std::lock_guard<std::mutex> guard(isolate_data->termination_lock_);
+  if (!isolate_data->is_executing_) {
+    return;
+  }
+
+  v8::HandleScope handle_scope(isolate);
+  auto context = isolate->GetCurrentContext();
+
+  if (args.Length() != 2 || !args[0]->IsObject() || !args[1]->IsArray() ||
+      args[0].As<v8::Object>()->InternalFieldCount() != kInternalFieldsCount) {
+    js_exception->ThrowEventingError(
+        "getMulti expects a bucket binding and an array of keys");
+    ++bucket_op_exception_count;
+    return;
+  }
+
+  auto keys_arr = args[1].As<v8::Array>();
+  std::vector<std::string> keys;
+  keys.reserve(keys_arr->Length());
+  for (uint32_t i = 0; i < keys_arr->Length(); ++i) {
+    v8::Local<v8::Value> key_val;
+    if (!TO_LOCAL(keys_arr->Get(context, i), &key_val)) {
+      return;
+    }
+
+    auto validate_info = Utils::ValidateDataType(key_val);
+    if (validate_info.is_fatal) {
+      js_exception->ThrowEventingError("Invalid data type for key - " +
+                                       validate_info.msg);
+      ++bucket_op_exception_count;
+      return;
+    }
+
+    // Same conversion as the one applied to the key of bucket[key]
+    v8::Local<v8::String> key_str;
+    if (!TO_LOCAL(key_val->ToString(context), &key_str)) {
+      return;
+    }
+    v8::String::Utf8Value utf8_key(isolate, key_str);
+    keys.emplace_back(*utf8_key);
+  }
+
+  auto bucket = UnwrapInternalField<Bucket>(args[0].As<v8::Object>(),
+                                            InternalFields::kBucketInstance);
+  auto [error, err_code, results] = bucket->GetMulti(keys);
+  if (error != nullptr) {
+    js_exception->ThrowEventingError(*error);
+    return;
+  }
+  if (*err_code != LCB_SUCCESS) {
+    HandleBucketOpFailure(isolate, bucket->GetConnection(), *err_code);
+    return;
+  }
+
+  auto value_name = v8Str(isolate, "value");
+  auto error_name = v8Str(isolate, "error");
+  auto result_obj = v8::Object::New(isolate);
+  for (std::size_t i = 0; i < keys.size(); ++i) {
+    const auto &result = (*results)[i];
+    auto entry = v8::Object::New(isolate);
+    auto is_set = false;
+    if (result.rc == LCB_SUCCESS) {
+      // A value that isn't JSON fails only its own key
+      v8::TryCatch try_catch(isolate);
+      v8::Local<v8::Value> value_json;
+      if (TO_LOCAL(v8::JSON::Parse(context, v8Str(isolate, result.value)),
+                   &value_json)) {
+        TO(entry->Set(context, value_name, value_json), &is_set);
+      } else {
+        ++bucket_op_exception_count;
+        TO(entry->Set(context, error_name, try_catch.Exception()), &is_set);
+      }
+    } else if (result.rc == LCB_KEY_ENOENT) {
+      TO(entry->Set(context, value_name, v8::Undefined(isolate)), &is_set);
+    } else {
+      AddLcbException(isolate_data, result.rc);
+      ++bucket_op_exception_count;
+      TO(entry->Set(context, error_name,
+                    js_exception->NewKVError(bucket->GetConnection(),
+                                             result.rc)),
+         &is_set);
+    }
+    TO(result_obj->Set(context, v8Str(isolate, keys[i]), entry), &is_set);
+  }
+  args.GetReturnValue().Set(result_obj);
+}
+
 Error BucketBinding::InstallBinding(v8::Isolate *isolate,
                                     const v8::Local<v8::Context> &context) {
   v8::HandleScope handle_scope(isolate);
@@ -558,6 +920,19 @@ Error BucketBinding::InstallBinding(v8::Isolate *isolate,
   (*obj)->SetInternalField(InternalFields::kIsSourceBucket,
                            v8::External::New(isolate, &is_source_bucket_));
 
+  // Handing out the same frozen object is safe only when the handler can't
+  // write to the bucket through this binding. It's bounded by the same size
+  // as the document cache
+  const auto isolate_data = UnwrapData(isolate);
+  if (block_mutation_ && isolate_data->bucket_cache_parsed_docs &&
+      isolate_data->bucket_cache_size > 0) {
+    parsed_doc_cache_ = std::make_shared<ParsedDocCache>(
+        isolate, isolate_data->bucket_cache_size);
+  }
+  (*obj)->SetInternalField(
+      InternalFields::kParsedDocCache,
+      v8::External::New(isolate, parsed_doc_cache_.get()));
+
   auto global = context->Global();
   auto result = false;
   if (!TO(global->Set(context, v8Str(isolate, bucket_alias_), *obj), &result) ||
@@ -684,3 +1059,7 @@ Info BucketBinding::ValidateKeyValue(const v8::Local<v8::Name> &key,
   }
   return {false};
 }
+
+void GetMultiFunction(const v8::FunctionCallbackInfo<v8::Value> &args) {
+  BucketBinding::GetMulti(args);
+}
@@ -0,0 +1,152 @@
+// Copyright (c) 2019 Couchbase, Inc.
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//     http://www.apache.org/licenses/LICENSE-2.0
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an "AS IS"
+// BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express
+// or implied. See the License for the specific language governing
+// permissions and limitations under the License.
+
+#include <vector>
+
+#include "bucket_cache.h"
+#include "utils.h"
+
+std::atomic<int64_t> bucket_cache_hit = {0};
+std::atomic<int64_t> bucket_cache_miss = {0};
+std::atomic<int64_t> bucket_cache_eviction = {0};
+std::atomic<int64_t> parsed_doc_cache_hit = {0};
+std::atomic<int64_t> parsed_doc_cache_miss = {0};
+
+const BucketCache::Entry *BucketCache::Get(const std::string &key) {
+  auto it = index_.find(key);
+  if (it == index_.end()) {
+    ++bucket_cache_miss;
+    return nullptr;
+  }
+
+  auto node = it->second;
+  if (node->expiry <= Clock::now()) {
+    lru_.erase(node);
+    index_.erase(it);
+    ++bucket_cache_miss;
+    return nullptr;
+  }
+
+  lru_.splice(lru_.begin(), lru_, node);
+  ++bucket_cache_hit;
+  return &node->entry;
+}
+
+void BucketCache::Put(const std::string &key, const std::string &value,
+                      lcb_CAS cas) {
+  if (capacity_ == 0) {
+    return;
+  }
+
+  const auto expiry = Clock::now() + max_age_;
+  auto it = index_.find(key);
+  if (it != index_.end()) {
+    auto node = it->second;
+    node->entry = {value, cas};
+    node->expiry = expiry;
+    lru_.splice(lru_.begin(), lru_, node);
+    return;
+  }
+
+  if (lru_.size() >= capacity_) {
+    index_.erase(lru_.back().key);
+    lru_.pop_back();
+    ++bucket_cache_eviction;
+  }
+  lru_.push_front({key, {value, cas}, expiry});
+  index_[key] = lru_.begin();
+}
+
+void BucketCache::Invalidate(const std::string &key) {
+  auto it = index_.find(key);
+  if (it == index_.end()) {
+    return;
+  }
+  lru_.erase(it->second);
+  index_.erase(it);
+}
+
+bool ParsedDocCache::Get(const std::string &key, lcb_CAS cas,
+                         v8::Local<v8::Value> *doc) {
+  auto it = index_.find(key);
+  if (it == index_.end() || it->second->cas != cas) {
+    ++parsed_doc_cache_miss;
+    return false;
+  }
+
+  lru_.splice(lru_.begin(), lru_, it->second);
+  *doc = it->second->doc.Get(isolate_);
+  ++parsed_doc_cache_hit;
+  return true;
+}
+
+bool ParsedDocCache::Put(const v8::Local<v8::Context> &context,
+                         const std::string &key, lcb_CAS cas,
+                         const v8::Local<v8::Value> &doc) {
+  if (capacity_ == 0 || !DeepFreeze(context, doc)) {
+    return false;
+  }
+
+  auto it = index_.find(key);
+  if (it != index_.end()) {
+    auto node = it->second;
+    node->cas = cas;
+    node->doc.Reset(isolate_, doc);
+    lru_.splice(lru_.begin(), lru_, node);
+    return true;
+  }
+
+  if (lru_.size() >= capacity_) {
+    index_.erase(lru_.back().key);
+    lru_.pop_back();
+  }
+  lru_.push_front({key, cas, v8::Global<v8::Value>(isolate_, doc)});
+  index_[key] = lru_.begin();
+  return true;
+}
+
+// Documents may be nested arbitrarily deep, hence not recursive
+bool ParsedDocCache::DeepFreeze(const v8::Local<v8::Context> &context,
+                                const v8::Local<v8::Value> &doc) const {
+  std::vector<v8::Local<v8::Object>> pending;
+  if (doc->IsObject()) {
+    pending.push_back(doc.As<v8::Object>());
+  }
+
+  while (!pending.empty()) {
+    auto obj = pending.back();
+    pending.pop_back();
+
+    v8::Local<v8::Array> names;
+    if (!TO_LOCAL(obj->GetOwnPropertyNames(context), &names)) {
+      return false;
+    }
+    for (uint32_t i = 0; i < names->Length(); ++i) {
+      v8::Local<v8::Value> name;
+      v8::Local<v8::Value> value;
+      if (!TO_LOCAL(names->Get(context, i), &name) ||
+          !TO_LOCAL(obj->Get(context, name), &value)) {
+        return false;
+      }
+      if (value->IsObject()) {
+        pending.push_back(value.As<v8::Object>());
+      }
+    }
+
+    auto is_frozen = false;
+    if (!TO(obj->SetIntegrityLevel(context, v8::IntegrityLevel::kFrozen),
+            &is_frozen) ||
+        !is_frozen) {
+      return false;
+    }
+  }
+  return true;
+}
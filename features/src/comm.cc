@@ -11,11 +11,138 @@
 
 #include <nlohmann/json.hpp>
 #include <sstream>
+#include <unordered_set>
 
 #include "comm.h"
 #include "isolate_data.h"
 #include "utils.h"
 
+constexpr std::chrono::seconds CredsCache::max_age;
+constexpr std::chrono::seconds CredsCache::refresh_age;
+
+bool CredsCache::Get(const std::string &endpoint, CredsInfo &info) {
+  std::lock_guard<std::mutex> guard(lock_);
+  auto it = entries_.find(endpoint);
+  if (it == entries_.end()) {
+    return false;
+  }
+  if (Clock::now() - it->second.fetched >= max_age) {
+    entries_.erase(it);
+    return false;
+  }
+  it->second.is_read = true;
+  info = it->second.info;
+  return true;
+}
+
+void CredsCache::Put(const std::string &endpoint, const CredsInfo &info) {
+  std::lock_guard<std::mutex> guard(lock_);
+  if (!info.is_valid) {
+    auto it = entries_.find(endpoint);
+    if (it != entries_.end()) {
+      it->second.is_refreshing = false;
+    }
+    return;
+  }
+  entries_[endpoint] = {info, Clock::now(), false, false};
+}
+
+std::vector<std::string> CredsCache::ClaimStale() {
+  std::lock_guard<std::mutex> guard(lock_);
+  const auto now = Clock::now();
+  std::vector<std::string> stale;
+  for (auto it = entries_.begin(); it != entries_.end();) {
+    auto &entry = it->second;
+    if (now - entry.fetched >= max_age) {
+      it = entries_.erase(it);
+      continue;
+    }
+    if (entry.is_read && !entry.is_refreshing &&
+        now - entry.fetched >= refresh_age) {
+      entry.is_refreshing = true;
+      stale.emplace_back(it->first);
+    }
+    ++it;
+  }
+  return stale;
+}
+
+void CredsCache::Clear() {
+  std::lock_guard<std::mutex> guard(lock_);
+  entries_.clear();
+}
+
+constexpr std::chrono::seconds KVNodesCache::max_age;
+constexpr std::chrono::seconds KVNodesCache::refresh_age;
+
+std::atomic<int64_t> kv_nodes_refresh_count = {0};
+std::atomic<int64_t> kv_nodes_refresh_failure = {0};
+std::atomic<int64_t> kv_nodes_refresh_latency_us = {0};
+
+bool KVNodesCache::Get(KVNodesInfo &info) {
+  std::lock_guard<std::mutex> guard(lock_);
+  if (!is_cached_ || Clock::now() - fetched_ >= max_age) {
+    return false;
+  }
+  is_read_ = true;
+  info = info_;
+  return true;
+}
+
+void KVNodesCache::Put(const KVNodesInfo &info) {
+  std::lock_guard<std::mutex> guard(lock_);
+  is_refreshing_ = false;
+  if (!info.is_valid || info.kv_nodes.empty()) {
+    return;
+  }
+  info_ = info;
+  fetched_ = Clock::now();
+  is_cached_ = true;
+  is_read_ = false;
+}
+
+bool KVNodesCache::ClaimStale() {
+  std::lock_guard<std::mutex> guard(lock_);
+  if (!is_cached_ || !is_read_ || is_refreshing_ ||
+      Clock::now() - fetched_ < refresh_age) {
+    return false;
+  }
+  is_refreshing_ = true;
+  return true;
+}
+
+void KVNodesCache::Clear() {
+  std::lock_guard<std::mutex> guard(lock_);
+  is_cached_ = false;
+}
+
+int64_t KVNodesCache::GetAge() {
+  std::lock_guard<std::mutex> guard(lock_);
+  if (!is_cached_) {
+    return -1;
+  }
+  return std::chrono::duration_cast<std::chrono::milliseconds>(Clock::now() -
+                                                               fetched_)
+      .count();
+}
+
+CredsCache Communicator::creds_cache_;
+KVNodesCache Communicator::kv_nodes_cache_;
+
+namespace {
+// The communicators the refresher can fetch through. Never destroyed, as the
+// refresher is still around while the statics are destroyed at exit
+struct LiveCommunicators {
+  std::mutex lock;
+  std::unordered_set<Communicator *> communicators;
+};
+
+LiveCommunicators &GetLiveCommunicators() {
+  static auto live = new LiveCommunicators();
+  return *live;
+}
+} // namespace
+
 Communicator::Communicator(const std::string &host_ip,
                            const std::string &host_port, const std::string &usr,
                            const std::string &key, bool ssl,
@@ -30,6 +157,17 @@ Communicator::Communicator(const std::string &host_ip,
   get_kv_nodes_url_ = base_url + "/getKVNodesAddresses";
   lo_usr_ = usr;
   lo_key_ = key;
+
+  auto &live = GetLiveCommunicators();
+  std::lock_guard<std::mutex> guard(live.lock);
+  live.communicators.insert(this);
+}
+
+// Waits for the refresher if it's fetching through this communicator
+Communicator::~Communicator() {
+  auto &live = GetLiveCommunicators();
+  std::lock_guard<std::mutex> guard(live.lock);
+  live.communicators.erase(this);
 }
 
 CredsInfo Communicator::ExtractCredentials(const std::string &encoded_str) {
@@ -51,6 +189,49 @@ CredsInfo Communicator::ExtractCredentials(const std::string &encoded_str) {
 }
 
 CredsInfo Communicator::GetCreds(const std::string &endpoint) {
+  CredsInfo info;
+  if (creds_cache_.Get(endpoint, info)) {
+    return info;
+  }
+
+  info = FetchCreds(endpoint);
+  creds_cache_.Put(endpoint, info);
+  StartRefresh();
+  return info;
+}
+
+// The caches are shared by the process and so is their refresher, a single
+// thread started upon the first fetch that lives as long as the process.
+// Credentials are also asked for by the threads that connect in background
+void Communicator::StartRefresh() {
+  static std::once_flag refresh_once;
+  std::call_once(refresh_once, [] {
+    std::thread(&Communicator::RefreshStale).detach();
+  });
+}
+
+// The endpoints are the same for all the communicators in the process, any of
+// them can fetch on behalf of the others
+void Communicator::RefreshStale() {
+  auto &live = GetLiveCommunicators();
+  while (true) {
+    std::this_thread::sleep_for(std::chrono::seconds(5));
+
+    std::lock_guard<std::mutex> guard(live.lock);
+    if (live.communicators.empty()) {
+      continue;
+    }
+    auto comm = *live.communicators.begin();
+    for (const auto &endpoint : creds_cache_.ClaimStale()) {
+      creds_cache_.Put(endpoint, comm->FetchCreds(endpoint));
+    }
+    if (kv_nodes_cache_.ClaimStale()) {
+      kv_nodes_cache_.Put(comm->FetchKVNodes());
+    }
+  }
+}
+
+CredsInfo Communicator::FetchCreds(const std::string &endpoint) {
   auto response = curl_.HTTPPost({"Content-Type: text/plain"}, get_creds_url_,
                                  endpoint, lo_usr_, lo_key_);
 
@@ -80,6 +261,32 @@ CredsInfo Communicator::GetCreds(const std::string &endpoint) {
 }
 
 KVNodesInfo Communicator::GetKVNodes() {
+  KVNodesInfo info;
+  if (kv_nodes_cache_.Get(info)) {
+    return info;
+  }
+
+  info = FetchKVNodes();
+  kv_nodes_cache_.Put(info);
+  StartRefresh();
+  return info;
+}
+
+KVNodesInfo Communicator::FetchKVNodes() {
+  const auto start = std::chrono::steady_clock::now();
+  auto info = GetKVNodesFromProducer();
+  kv_nodes_refresh_latency_us =
+      std::chrono::duration_cast<std::chrono::microseconds>(
+          std::chrono::steady_clock::now() - start)
+          .count();
+  ++kv_nodes_refresh_count;
+  if (!info.is_valid) {
+    ++kv_nodes_refresh_failure;
+  }
+  return info;
+}
+
+KVNodesInfo Communicator::GetKVNodesFromProducer() {
   // TODO : Use GET here instead of POST
   auto response = curl_.HTTPPost({}, get_kv_nodes_url_, "", lo_usr_, lo_key_);
 
@@ -115,7 +322,9 @@ KVNodesInfo Communicator::GetKVNodes() {
   return info;
 }
 
-void Communicator::Refresh() { creds_cache_.clear(); }
+void Communicator::Refresh() { creds_cache_.Clear(); }
+
+void Communicator::RefreshKVNodes() { kv_nodes_cache_.Clear(); }
 
 void Communicator::WriteDebuggerURL(const std::string &url) {
   auto response = curl_.HTTPPost({"Content-Type: text/plain"},
@@ -61,6 +61,13 @@ void JsException::CopyMembers(JsException &&exc_obj) {
 // Extracts the error message, composes an exception object and throws.
 void JsException::ThrowKVError(lcb_t instance, lcb_error_t error) {
   v8::HandleScope handle_scope(isolate_);
+  isolate_->ThrowException(NewKVError(instance, error));
+}
+
+// Composes the exception object for error without throwing it.
+v8::Local<v8::Value> JsException::NewKVError(lcb_t instance,
+                                             lcb_error_t error) {
+  v8::EscapableHandleScope handle_scope(isolate_);
 
   auto code_name = code_.Get(isolate_);
   auto desc_name = desc_.Get(isolate_);
@@ -81,10 +88,9 @@ void JsException::ThrowKVError(lcb_t instance, lcb_error_t error) {
   auto info = custom_error->NewKVError(message, error_obj);
   if (info.is_fatal) {
     LOG(logError) << "Unable to construct KVError : " << info.msg << std::endl;
-    isolate_->ThrowException(message);
-    return;
+    return handle_scope.Escape(message);
   }
-  isolate_->ThrowException(error_obj);
+  return handle_scope.Escape(error_obj);
 }
 
 void JsException::ThrowKVError(const std::string &err_msg) {
@@ -17,6 +17,9 @@
 
 #define EVT_LOG_MSG_SIZE 1024
 
+std::atomic<int64_t> lcb_retry_attempts = {0};
+std::atomic<int64_t> lcb_retry_time_us = {0};
+
 const char *GetUsername(void *cookie, const char *host, const char *port,
                         const char *bucket) {
   LOG(logDebug) << "Getting username for host " << RS(host) << " port " << port
@@ -9,6 +9,9 @@
 // or implied. See the License for the specific language governing
 // permissions and limitations under the License.
 
+#include <memory>
+#include <mutex>
+
 #include "transpiler.h"
 #include "log.h"
 #include "retry_util.h"
@@ -21,15 +24,38 @@ Transpiler::Transpiler(v8::Isolate *isolate, const std::string &transpiler_src,
     : isolate_(isolate), transpiler_src_(transpiler_src),
       source_bucket_(source_bucket), handler_headers_(handler_headers),
       handler_footers_(handler_footers) {
+  auto context = v8::Context::New(isolate, nullptr, NewGlobalObj(isolate));
+  context_.Reset(isolate, context);
+}
+
+Transpiler::Transpiler(v8::Isolate *isolate,
+                       const v8::Local<v8::Context> &context,
+                       const std::string &transpiler_src,
+                       const std::vector<std::string> &handler_headers,
+                       const std::vector<std::string> &handler_footers,
+                       const std::string &source_bucket)
+    : isolate_(isolate), transpiler_src_(transpiler_src),
+      source_bucket_(source_bucket), handler_headers_(handler_headers),
+      handler_footers_(handler_footers), is_bundle_loaded_(true) {
+  context_.Reset(isolate, context);
+}
+
+Transpiler::~Transpiler() {
+  for (auto &function : functions_) {
+    function.Reset();
+  }
+  context_.Reset();
+}
+
+v8::Local<v8::ObjectTemplate> Transpiler::NewGlobalObj(v8::Isolate *isolate) {
+  v8::EscapableHandleScope handle_scope(isolate);
+
   auto global = v8::ObjectTemplate::New(isolate);
   global->Set(v8Str(isolate, "log"),
               v8::FunctionTemplate::New(isolate, Transpiler::Log));
-  auto context = v8::Context::New(isolate, nullptr, global);
-  context_.Reset(isolate, context);
+  return handle_scope.Escape(global);
 }
 
-Transpiler::~Transpiler() { context_.Reset(); }
-
 void Transpiler::Log(const v8::FunctionCallbackInfo<v8::Value> &args) {
   auto isolate = args.GetIsolate();
   v8::Locker locker(isolate);
@@ -44,29 +70,101 @@ void Transpiler::Log(const v8::FunctionCallbackInfo<v8::Value> &args) {
   std::cerr << log_msg << std::endl;
 }
 
-v8::Local<v8::Value> Transpiler::ExecTranspiler(const std::string &function,
-                                                v8::Local<v8::Value> args[],
-                                                const int &args_len) {
-  v8::EscapableHandleScope handle_scope(isolate_);
-  auto context = context_.Get(isolate_);
-  v8::Context::Scope context_scope(context);
+namespace {
+// The bundle is the same for every Transpiler in the process, so is the code
+// cache for it
+std::mutex bundle_cache_lock;
+std::shared_ptr<const std::string> bundle_cache;
+} // namespace
+
+// Compiles and runs the transpiler bundle in context, which defines the
+// functions of transpiler.js as globals. This is done just once per
+// Transpiler as the bundle keeps no state between calls
+bool Transpiler::LoadBundle(const v8::Local<v8::Context> &context) {
+  v8::HandleScope handle_scope(isolate_);
 
-  v8::Local<v8::Value> result;
-  auto source = v8Str(isolate_, transpiler_src_);
-  auto global = context->Global();
+  std::shared_ptr<const std::string> cached;
+  {
+    std::lock_guard<std::mutex> guard(bundle_cache_lock);
+    cached = bundle_cache;
+  }
+
+  v8::ScriptCompiler::CachedData *cached_data = nullptr;
+  if (cached != nullptr) {
+    cached_data = new v8::ScriptCompiler::CachedData(
+        reinterpret_cast<const uint8_t *>(cached->data()),
+        static_cast<int>(cached->size()));
+  }
 
+  v8::ScriptCompiler::Source source(v8Str(isolate_, transpiler_src_),
+                                    cached_data);
+  auto options = cached_data != nullptr
+                     ? v8::ScriptCompiler::kConsumeCodeCache
+                     : v8::ScriptCompiler::kNoCompileOptions;
   v8::Local<v8::Script> script;
-  if (!TO_LOCAL(v8::Script::Compile(context, source), &script)) {
-    return handle_scope.Escape(result);
+  if (!TO_LOCAL(v8::ScriptCompiler::Compile(context, &source, options),
+                &script)) {
+    return false;
   }
 
+  v8::Local<v8::Value> result;
   if (!TO_LOCAL(script->Run(context), &result)) {
-    return handle_scope.Escape(result);
+    return false;
+  }
+
+  if (cached_data == nullptr || source.GetCachedData()->rejected) {
+    std::unique_ptr<v8::ScriptCompiler::CachedData> code_cache(
+        v8::ScriptCompiler::CreateCodeCache(script->GetUnboundScript()));
+    if (code_cache != nullptr) {
+      std::lock_guard<std::mutex> guard(bundle_cache_lock);
+      bundle_cache = std::make_shared<const std::string>(
+          reinterpret_cast<const char *>(code_cache->data),
+          static_cast<std::size_t>(code_cache->length));
+    }
+  }
+  return true;
+}
+
+bool Transpiler::GetFunction(const v8::Local<v8::Context> &context,
+                             Function function,
+                             v8::Local<v8::Function> *function_ref) {
+  if (!functions_[function].IsEmpty()) {
+    *function_ref = functions_[function].Get(isolate_);
+    return true;
+  }
+
+  if (!is_bundle_loaded_) {
+    if (!LoadBundle(context)) {
+      return false;
+    }
+    is_bundle_loaded_ = true;
   }
 
-  auto function_name = v8Str(isolate_, function);
+  static const char *names[kNumFunctions] = {"compile", "AddHeadersAndFooters",
+                                             "getCodeVersion"};
+  auto function_name = v8Str(isolate_, names[function]);
   v8::Local<v8::Value> function_def;
-  if (!TO_LOCAL(global->Get(context, function_name), &function_def)) {
+  if (!TO_LOCAL(context->Global()->Get(context, function_name),
+                &function_def) ||
+      !function_def->IsFunction()) {
+    return false;
+  }
+
+  *function_ref = function_def.As<v8::Function>();
+  functions_[function].Reset(isolate_, *function_ref);
+  return true;
+}
+
+v8::Local<v8::Value> Transpiler::ExecTranspiler(Function function,
+                                                v8::Local<v8::Value> args[],
+                                                const int &args_len) {
+  v8::EscapableHandleScope handle_scope(isolate_);
+  auto context = context_.Get(isolate_);
+  v8::Context::Scope context_scope(context);
+
+  v8::Local<v8::Value> result;
+  v8::Local<v8::Function> function_ref;
+  if (!GetFunction(context, function, &function_ref)) {
     return handle_scope.Escape(result);
   }
 
@@ -74,7 +172,6 @@ v8::Local<v8::Value> Transpiler::ExecTranspiler(const std::string &function,
                         IsTerminatingRetriable, IsExecutionTerminating,
                         isolate_);
 
-  auto function_ref = function_def.As<v8::Function>();
   TO_LOCAL(function_ref->Call(context, function_ref, args_len, args), &result);
   return handle_scope.Escape(result);
 }
@@ -85,7 +182,7 @@ CompilationInfo Transpiler::Compile(const std::string &n1ql_js_src) {
   args[0] = v8Str(isolate_, n1ql_js_src);
   args[1] = v8Array(isolate_, handler_headers_);
   args[2] = v8Array(isolate_, handler_footers_);
-  auto result = ExecTranspiler("compile", args, 3);
+  auto result = ExecTranspiler(kCompile, args, 3);
 
   return ComposeCompilationInfo(result);
 }
@@ -96,7 +193,7 @@ std::string Transpiler::AddHeadersAndFooters(const std::string &handler_code) {
   args[0] = v8Str(isolate_, handler_code);
   args[1] = v8Array(isolate_, handler_headers_);
   args[2] = v8Array(isolate_, handler_footers_);
-  auto result = ExecTranspiler("AddHeadersAndFooters", args, 3);
+  auto result = ExecTranspiler(kAddHeadersAndFooters, args, 3);
 
   v8::String::Utf8Value utf8result(isolate_, result);
   return *utf8result;
@@ -108,7 +205,7 @@ CodeVersion Transpiler::GetCodeVersion(const std::string &handler_code) {
 
   v8::Local<v8::Value> args[1];
   args[0] = v8Str(isolate_, handler_code);
-  auto res = ExecTranspiler("getCodeVersion", args, 1);
+  auto res = ExecTranspiler(kGetCodeVersion, args, 1);
   auto ans = res.As<v8::Array>();
 
   v8::Local<v8::Value> version_val;
@@ -88,6 +88,14 @@ function getCodeVersion(code) {
         sourceType: 'script'
     });
 
+    // Older releases know of neither batch entry point
+    for (var node of ast.body) {
+        if (/FunctionDeclaration/.test(node.type) &&
+            (node.id.name === 'OnUpdateBatch' || node.id.name === 'OnDeleteBatch')) {
+            if (vp < 2) vp = 2;
+        }
+    }
+
     estraverse.traverse(ast, {
         // todo: handle aliased functions, ex: var cn = cronTimer
         enter: function (node) {
@@ -96,7 +104,8 @@ function getCodeVersion(code) {
                     tp = 1;
                     if (vp < 1) vp = 1;
                 }
-                if (node.callee.name === 'crc64' || node.callee.name === 'curl') {
+                if (node.callee.name === 'crc64' || node.callee.name === 'curl' ||
+                    node.callee.name === 'getMulti') {
                     if (vp < 2) vp = 2;
                 }
             }
@@ -148,7 +157,8 @@ NodeUtils.prototype.checkGlobals = function (ast) {
             };
         }
 
-        if (node.id.name === "OnUpdate" || node.id.name === "OnDelete") {
+        if (node.id.name === "OnUpdate" || node.id.name === "OnDelete" ||
+            node.id.name === "OnUpdateBatch" || node.id.name === "OnDeleteBatch") {
             check = true;
         }
     }
@@ -157,7 +167,7 @@ NodeUtils.prototype.checkGlobals = function (ast) {
             index: 1,
             lineNumber: 1,
             column: 1,
-            description: 'Handler code is missing OnUpdate() and OnDelete() functions. At least one of them is needed to deploy the handler'
+            description: 'Handler code is missing OnUpdate(), OnDelete(), OnUpdateBatch() and OnDeleteBatch() functions. At least one of them is needed to deploy the handler'
         };
     }
 };
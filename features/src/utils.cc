@@ -87,6 +87,20 @@ v8::Local<v8::String> v8Str(v8::Isolate *isolate, const std::string &str) {
   return handle_scope.Escape(v8::String::Empty(isolate));
 }
 
+v8::Local<v8::String> v8Str(v8::Isolate *isolate, std::string_view str) {
+  v8::EscapableHandleScope handle_scope(isolate);
+
+  auto v8maybe_str =
+      v8::String::NewFromUtf8(isolate, str.data(), v8::NewStringType::kNormal,
+                              static_cast<int>(str.length()));
+  v8::Local<v8::String> v8local_str;
+  if (TO_LOCAL(v8maybe_str, &v8local_str)) {
+    return handle_scope.Escape(v8local_str);
+  }
+
+  return handle_scope.Escape(v8::String::Empty(isolate));
+}
+
 v8::Local<v8::Name> v8Name(v8::Isolate *isolate, uint32_t key) {
   v8::EscapableHandleScope handle_scope(isolate);
 
@@ -111,6 +125,9 @@ v8::Local<v8::Array> v8Array(v8::Isolate *isolate,
   return handle_scope.Escape(array);
 }
 
+// v8::JSON::Stringify runs the same builtin as JSON.stringify, minus the
+// lookups of JSON and stringify on the global object. Values which
+// JSON.stringify maps to undefined come out as "undefined", as before
 std::string JSONStringify(v8::Isolate *isolate,
                           const v8::Local<v8::Value> &object) {
   if (IS_EMPTY(object)) {
@@ -118,37 +135,14 @@ std::string JSONStringify(v8::Isolate *isolate,
   }
 
   v8::HandleScope handle_scope(isolate);
-
   auto context = isolate->GetCurrentContext();
-  auto global = context->Global();
 
-  auto key = v8Str(isolate, "JSON");
-  v8::Local<v8::Value> v8val_json;
-  if (!TO_LOCAL(global->Get(context, key), &v8val_json)) {
+  v8::Local<v8::String> v8str_result;
+  if (!TO_LOCAL(v8::JSON::Stringify(context, object), &v8str_result)) {
     return "";
   }
 
-  v8::Local<v8::Object> v8obj_json;
-  if (!TO_LOCAL(v8val_json->ToObject(context), &v8obj_json)) {
-    return "";
-  }
-
-  key = v8Str(isolate, "stringify");
-  v8::Local<v8::Value> v8val_stringify;
-  if (!TO_LOCAL(v8obj_json->Get(context, key), &v8val_stringify)) {
-    return "";
-  }
-
-  auto v8fun_stringify = v8val_stringify.As<v8::Function>();
-  v8::Local<v8::Value> args[1] = {object};
-
-  v8::Local<v8::Value> v8obj_result;
-  if (!TO_LOCAL(v8fun_stringify->Call(context, global, 1, args),
-                &v8obj_result)) {
-    return "";
-  }
-
-  v8::String::Utf8Value utf8_result(isolate, v8obj_result);
+  v8::String::Utf8Value utf8_result(isolate, v8str_result);
   return *utf8_result;
 }
 
@@ -456,7 +450,7 @@ ConnStrInfo Utils::GetConnectionString(const std::string &bucket) const {
     return conn_info;
   }
   conn_info.is_valid = true;
-  conn_info.conn_str = GetConnectionStr(nodes_info.kv_nodes.front(), bucket);
+  conn_info.conn_str = GetConnectionStr(nodes_info.kv_nodes, bucket);
   return conn_info;
 }
 
@@ -663,11 +657,16 @@ void Crc64Function(const v8::FunctionCallbackInfo<v8::Value> &args) {
   args.GetReturnValue().Set(v8Str(isolate, crc_str));
 }
 
-std::string GetConnectionStr(const std::string &end_point,
+// Lists all the KV nodes so that bootstrap can move on to the next one when a
+// node is unreachable
+std::string GetConnectionStr(const std::vector<std::string> &end_points,
                              const std::string &bucket_name) {
   std::stringstream conn_str;
-  conn_str << "couchbase://" << end_point << '/' << bucket_name
-           << "?select_bucket=true&detailed_errcodes=1";
+  conn_str << "couchbase://";
+  for (std::size_t i = 0; i < end_points.size(); ++i) {
+    conn_str << (i == 0 ? "" : ",") << end_points[i];
+  }
+  conn_str << '/' << bucket_name << "?select_bucket=true&detailed_errcodes=1";
   if (IsIPv6()) {
     conn_str << "&ipv6=allow";
   }
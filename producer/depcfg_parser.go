@@ -103,6 +103,12 @@ func (p *Producer) parseDepcfg() error {
 		p.handlerConfig.N1qlPrepareAll = false
 	}
 
+	if val, ok := settings["pipeline_bucket_writes"]; ok {
+		p.handlerConfig.PipelineBucketWrites = val.(bool)
+	} else {
+		p.handlerConfig.PipelineBucketWrites = false
+	}
+
 	if val, ok := settings["language_compatibility"]; ok {
 		p.handlerConfig.LanguageCompatibility = val.(string)
 	} else {
@@ -244,6 +250,48 @@ func (p *Producer) parseDepcfg() error {
 	} else {
 		p.handlerConfig.LcbRetryCount = 0
 	}
+
+	if val, ok := settings["bucket_cache_size"]; ok {
+		p.handlerConfig.BucketCacheSize = int(val.(float64))
+	} else {
+		p.handlerConfig.BucketCacheSize = 0
+	}
+
+	if val, ok := settings["bucket_cache_age"]; ok {
+		p.handlerConfig.BucketCacheAge = int(val.(float64))
+	} else {
+		p.handlerConfig.BucketCacheAge = 1000
+	}
+
+	if val, ok := settings["bucket_cache_parsed_docs"]; ok {
+		p.handlerConfig.BucketCacheParsedDocs = val.(bool)
+	} else {
+		p.handlerConfig.BucketCacheParsedDocs = false
+	}
+
+	if val, ok := settings["bucket_op_timeout"]; ok {
+		p.handlerConfig.BucketOpTimeout = int(val.(float64))
+	} else {
+		p.handlerConfig.BucketOpTimeout = 2500
+	}
+
+	if val, ok := settings["n1ql_min_connections"]; ok {
+		p.handlerConfig.N1qlMinConnections = int(val.(float64))
+	} else {
+		p.handlerConfig.N1qlMinConnections = 0
+	}
+
+	if val, ok := settings["n1ql_prefetch_rows"]; ok {
+		p.handlerConfig.N1qlPrefetchRows = int(val.(float64))
+	} else {
+		p.handlerConfig.N1qlPrefetchRows = 16
+	}
+
+	if val, ok := settings["n1ql_prefetch_bytes"]; ok {
+		p.handlerConfig.N1qlPrefetchBytes = int(val.(float64))
+	} else {
+		p.handlerConfig.N1qlPrefetchBytes = 1048576
+	}
 	// Metastore related configuration
 
 	if val, ok := settings["execute_timer_routine_count"]; ok {
@@ -92,6 +92,7 @@ func (m *ServiceMgr) fillMissingWithDefaults(appName string, settings map[string
 
 	// Handler related configurations
 	fillMissingDefault(app, settings, "n1ql_prepare_all", false)
+	fillMissingDefault(app, settings, "pipeline_bucket_writes", false)
 	fillMissingDefault(app, settings, "checkpoint_interval", float64(60000))
 	fillMissingDefault(app, settings, "cleanup_timers", false)
 	fillMissingDefault(app, settings, "cpp_worker_thread_count", float64(2))
@@ -144,6 +145,13 @@ func (m *ServiceMgr) fillMissingWithDefaults(appName string, settings map[string
 	// Language related configuration
 	fillMissingDefault(app, settings, "language_compatibility", common.LanguageCompatibility[0])
 	fillMissingDefault(app, settings, "lcb_retry_count", float64(0))
+	fillMissingDefault(app, settings, "bucket_cache_size", float64(0))
+	fillMissingDefault(app, settings, "bucket_cache_age", float64(1000))
+	fillMissingDefault(app, settings, "bucket_cache_parsed_docs", false)
+	fillMissingDefault(app, settings, "bucket_op_timeout", float64(2500))
+	fillMissingDefault(app, settings, "n1ql_min_connections", float64(0))
+	fillMissingDefault(app, settings, "n1ql_prefetch_rows", float64(16))
+	fillMissingDefault(app, settings, "n1ql_prefetch_bytes", float64(1048576))
 }
 
 func fillMissingDefault(app application, settings map[string]interface{}, field string, defaultValue interface{}) {
@@ -775,6 +775,9 @@ func (m *ServiceMgr) validateSettings(appName string, settings map[string]interf
 	if info = m.validateBoolean("n1ql_prepare_all", false, settings); info.Code != m.statusCodes.ok.Code {
 		return
 	}
+	if info = m.validateBoolean("pipeline_bucket_writes", false, settings); info.Code != m.statusCodes.ok.Code {
+		return
+	}
 	if info = m.validatePossibleValues("language_compatibility", settings, common.LanguageCompatibility); info.Code != m.statusCodes.ok.Code {
 		return
 	}
@@ -971,6 +974,41 @@ func (m *ServiceMgr) validateSettings(appName string, settings map[string]interf
 		return
 	}
 
+	if info = m.validateNonNegativeInteger("bucket_cache_size", settings); info.Code != m.statusCodes.ok.Code {
+		return
+	}
+
+	if info = m.validateNonNegativeInteger("bucket_cache_age", settings); info.Code != m.statusCodes.ok.Code {
+		return
+	}
+
+	if info = m.validateBoolean("bucket_cache_parsed_docs", false, settings); info.Code != m.statusCodes.ok.Code {
+		return
+	}
+
+	if info = m.validatePositiveInteger("bucket_op_timeout", settings); info.Code != m.statusCodes.ok.Code {
+		return
+	}
+
+	// The timeout is handed to the SDK in microseconds as a 32-bit value
+	if val, ok := settings["bucket_op_timeout"]; ok && val.(float64) > 3600000 {
+		info.Code = m.statusCodes.errInvalidConfig.Code
+		info.Info = "bucket_op_timeout can not be more than 3600000 ms"
+		return
+	}
+
+	if info = m.validateNonNegativeInteger("n1ql_min_connections", settings); info.Code != m.statusCodes.ok.Code {
+		return
+	}
+
+	if info = m.validatePositiveInteger("n1ql_prefetch_rows", settings); info.Code != m.statusCodes.ok.Code {
+		return
+	}
+
+	if info = m.validatePositiveInteger("n1ql_prefetch_bytes", settings); info.Code != m.statusCodes.ok.Code {
+		return
+	}
+
 	info.Code = m.statusCodes.ok.Code
 	return
 }
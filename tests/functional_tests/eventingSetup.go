@@ -690,6 +690,14 @@ func waitForStatusChange(appName, expectedStatus string, retryCounter int) {
 }
 
 func getFailureStatCounter(statName, fnName string) int {
+	return getStatCounter("failure_stats", statName, fnName)
+}
+
+func getExecutionStatCounter(statName, fnName string) int {
+	return getStatCounter("execution_stats", statName, fnName)
+}
+
+func getStatCounter(statGroup, statName, fnName string) int {
 	responses := make([]interface{}, 0)
 
 	res0, err := makeStatsRequest("", statsEndpointURL0, false)
@@ -732,11 +740,11 @@ func getFailureStatCounter(statName, fnName string) int {
 			}
 
 			if sFName == fnName {
-				failureStats, ok := s["failure_stats"].(map[string]interface{})
+				groupStats, ok := s[statGroup].(map[string]interface{})
 				if !ok {
 					continue
 				}
-				if val, ok := failureStats[statName].(float64); !ok {
+				if val, ok := groupStats[statName].(float64); !ok {
 					continue
 				} else {
 					result += int(val)
@@ -9,6 +9,8 @@ import (
 	"strings"
 	"testing"
 	"time"
+
+	"gopkg.in/couchbase/gocb.v1"
 )
 
 func testEnoent(itemCount int, handler string, settings *commonSettings, t *testing.T) {
@@ -1809,3 +1811,148 @@ func TestN1QLAllowRecursion(t *testing.T) {
 
 	log.Printf("Success: %s is deployed after allow_interbucket_recursion", functionName2)
 }
+
+func TestOnUpdateBatchBucketOp(t *testing.T) {
+	functionName := t.Name()
+
+	time.Sleep(5 * time.Second)
+	handler := "bucket_op_on_update_batch"
+	flushFunctionAndBucket(functionName)
+	createAndDeployFunction(functionName, handler, &commonSettings{})
+
+	pumpBucketOps(opsType{}, &rateLimit{})
+	eventCount := verifyBucketOps(itemCount, statsLookupRetryCounter)
+	if itemCount != eventCount {
+		t.Error("For", "OnUpdateBatchBucketOp",
+			"expected", itemCount,
+			"got", eventCount,
+		)
+	}
+
+	dumpStats()
+	flushFunctionAndBucket(functionName)
+}
+
+func TestOnDeleteBatchBucketOp(t *testing.T) {
+	functionName := t.Name()
+
+	time.Sleep(5 * time.Second)
+	handler := "bucket_op_on_delete_batch"
+	flushFunctionAndBucket(functionName)
+	createAndDeployFunction(functionName, handler, &commonSettings{})
+
+	pumpBucketOps(opsType{delete: true}, &rateLimit{})
+	eventCount := verifyBucketOps(itemCount, statsLookupRetryCounter)
+	if itemCount != eventCount {
+		t.Error("For", "OnDeleteBatchBucketOp",
+			"expected", itemCount,
+			"got", eventCount,
+		)
+	}
+
+	dumpStats()
+	flushFunctionAndBucket(functionName)
+}
+
+// A document that can't be handed to V8 fails on its own, the rest of its
+// batch is still processed and checkpointed
+func TestOnUpdateBatchSkipBadEvent(t *testing.T) {
+	functionName := t.Name()
+
+	time.Sleep(5 * time.Second)
+	handler := "bucket_op_on_update_batch"
+	flushFunctionAndBucket(functionName)
+	createAndDeployFunction(functionName, handler, &commonSettings{})
+
+	cluster, _ := gocb.Connect("couchbase://127.0.0.1:12000")
+	cluster.Authenticate(gocb.PasswordAuthenticator{
+		Username: rbacuser,
+		Password: rbacpass,
+	})
+	bucket, err := cluster.OpenBucket(srcBucket, "")
+	if err != nil {
+		t.Error("Bucket open, err:", err)
+		return
+	}
+	defer bucket.Close()
+
+	// Valid JSON to KV, but nested too deeply for V8's JSON parser
+	depth := 100000
+	badDoc := []byte(strings.Repeat("[", depth) + strings.Repeat("]", depth))
+
+	pumpBucketOps(opsType{count: itemCount / 2}, &rateLimit{})
+	_, err = bucket.Upsert("bad_doc_id", badDoc, 0)
+	if err != nil {
+		t.Error("Failed to write bad document, err:", err)
+		return
+	}
+	pumpBucketOps(opsType{count: itemCount / 2, startIndex: itemCount / 2},
+		&rateLimit{})
+
+	eventCount := verifyBucketOps(itemCount, statsLookupRetryCounter)
+	if itemCount != eventCount {
+		t.Error("For", "OnUpdateBatchSkipBadEvent",
+			"expected", itemCount,
+			"got", eventCount,
+		)
+	}
+
+	failureCount := getExecutionStatCounter("on_update_failure", functionName)
+	if failureCount != 1 {
+		t.Error("For", "OnUpdateBatchSkipBadEvent",
+			"expected on_update_failure", 1,
+			"got", failureCount,
+		)
+	}
+
+	// The bad event is checkpointed along with the rest of its batch, so it
+	// isn't replayed on resume. Pausing restarts the consumers and with them
+	// the counter
+	setSettings(functionName, true, false, &commonSettings{})
+	waitForStatusChange(functionName, "paused", statsLookupRetryCounter)
+	setSettings(functionName, true, true,
+		&commonSettings{streamBoundary: "from_prior"})
+	waitForStatusChange(functionName, "deployed", statsLookupRetryCounter)
+
+	pumpBucketOps(opsType{startIndex: itemCount}, &rateLimit{})
+	eventCount = verifyBucketOps(itemCount*2, statsLookupRetryCounter)
+	if itemCount*2 != eventCount {
+		t.Error("For", "OnUpdateBatchSkipBadEvent",
+			"expected", itemCount*2,
+			"got", eventCount,
+		)
+	}
+
+	failureCount = getExecutionStatCounter("on_update_failure", functionName)
+	if failureCount != 0 {
+		t.Error("For", "OnUpdateBatchSkipBadEvent",
+			"expected on_update_failure after resume", 0,
+			"got", failureCount,
+		)
+	}
+
+	dumpStats()
+	flushFunctionAndBucket(functionName)
+}
+
+func TestGetMultiBucketOp(t *testing.T) {
+	functionName := t.Name()
+
+	time.Sleep(5 * time.Second)
+	handler := "bucket_op_get_multi"
+	flushFunctionAndBucket(functionName)
+	createAndDeployFunction(functionName, handler, &commonSettings{})
+
+	pumpBucketOps(opsType{}, &rateLimit{})
+	expectedCount := itemCount * 2
+	eventCount := verifyBucketOps(expectedCount, statsLookupRetryCounter)
+	if expectedCount != eventCount {
+		t.Error("For", "GetMultiBucketOp",
+			"expected", expectedCount,
+			"got", eventCount,
+		)
+	}
+
+	dumpStats()
+	flushFunctionAndBucket(functionName)
+}
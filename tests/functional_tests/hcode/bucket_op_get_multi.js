@@ -0,0 +1,9 @@
+function OnUpdate(doc, meta) {
+    dst_bucket[meta.id] = doc;
+    var res = getMulti(dst_bucket, [meta.id, meta.id + '_missing']);
+    if (res[meta.id].value !== undefined &&
+        res[meta.id + '_missing'].value === undefined &&
+        res[meta.id + '_missing'].error === undefined) {
+        dst_bucket[meta.id + '_found'] = 'hello world';
+    }
+}
@@ -0,0 +1,5 @@
+function OnDeleteBatch(metas) {
+    for (var i = 0; i < metas.length; i++) {
+        dst_bucket[metas[i].id + "abc"] = 'hello world';
+    }
+}
@@ -0,0 +1,17 @@
+function OnUpdate(doc, meta) {
+    var lim = 5,
+    rowCount = 0,
+    batchCount = 0;
+
+    var res = SELECT * FROM default LIMIT $lim;
+    for (var rows of res.batch(2)) {
+        rowCount += rows.length;
+        ++batchCount;
+    }
+    res.close();
+
+    // 2 full batches and a partial one
+    if (rowCount === 5 && batchCount === 3) {
+        dst_bucket[meta.id] = 'hello world';
+    }
+}
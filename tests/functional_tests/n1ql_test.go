@@ -309,3 +309,23 @@ func TestN1QLGraceSufficientTimeOut(t *testing.T) {
 
 	dumpStats()
 }
+
+func TestN1QLBatch(t *testing.T) {
+	functionName := t.Name()
+	handler := "n1ql_batch"
+	flushFunctionAndBucket(functionName)
+	pumpBucketOps(opsType{}, &rateLimit{})
+	createAndDeployFunction(functionName, handler, &commonSettings{})
+	waitForDeployToFinish(functionName)
+
+	eventCount := verifyBucketOps(itemCount, statsLookupRetryCounter*2)
+	if itemCount != eventCount {
+		t.Error("For", "N1QLBatch",
+			"expected", itemCount,
+			"got", eventCount,
+		)
+	}
+
+	dumpStats()
+	flushFunctionAndBucket(functionName)
+}
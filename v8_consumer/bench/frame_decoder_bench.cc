@@ -0,0 +1,190 @@
+// Copyright (c) 2019 Couchbase, Inc.
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//     http://www.apache.org/licenses/LICENSE-2.0
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an "AS IS"
+// BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express
+// or implied. See the License for the specific language governing
+// permissions and limitations under the License.
+
+// Measures the throughput of the IPC frame decoding in
+// AppWorker::ParseValidChunk. Synthetic frames are fed in reads of
+// MAX_BUF_SIZE bytes, as libuv hands them over, through FrameDecoder and
+// through the decoding that it replaced. Both copy out the header and
+// payload of each frame, as GetWorkerMessage does
+//
+// Usage: eventing-frame-decoder-bench [total_mb] [payload_size]
+
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "frame_decoder.h"
+
+const std::size_t READ_SIZE = 65536; // MAX_BUF_SIZE in client.h
+const std::size_t HEADER_SIZE = 64;
+
+struct Sink {
+  std::string header;
+  std::string payload;
+  std::size_t frames{0};
+  std::size_t bytes{0};
+
+  void Consume(const char *header_start, uint32_t header_size,
+               uint32_t payload_size) {
+    header.assign(header_start, header_size);
+    payload.assign(header_start + header_size, payload_size);
+    ++frames;
+    bytes += header.size() + payload.size();
+  }
+};
+
+// The decoding as it was before FrameDecoder
+class LegacyDecoder {
+public:
+  void Feed(const char *buf, int nread, Sink &sink) {
+    std::string buf_base;
+    for (int i = 0; i < nread; i++) {
+      buf_base += buf[i];
+    }
+
+    if (next_message_.length() > 0) {
+      buf_base = next_message_ + buf_base;
+      next_message_.clear();
+    }
+
+    for (; buf_base.length() > FrameDecoder::prefix_size;) {
+      std::vector<int> header_entries, payload_entries;
+      for (std::size_t i = 0; i < FrameDecoder::length_size; i++) {
+        header_entries.push_back(int(buf_base[i]));
+      }
+      auto encoded_header_size = CombineAsciiToInt(&header_entries);
+
+      for (auto i = FrameDecoder::length_size; i < FrameDecoder::prefix_size;
+           i++) {
+        payload_entries.push_back(int(buf_base[i]));
+      }
+      auto encoded_payload_size = CombineAsciiToInt(&payload_entries);
+
+      std::string::size_type message_size = FrameDecoder::prefix_size +
+                                            encoded_header_size +
+                                            encoded_payload_size;
+      if (buf_base.length() < message_size) {
+        next_message_.assign(buf_base);
+        return;
+      }
+
+      std::string chunk_to_parse = buf_base.substr(0, message_size);
+      auto header = chunk_to_parse.substr(FrameDecoder::prefix_size,
+                                          encoded_header_size);
+      auto payload = chunk_to_parse.substr(
+          FrameDecoder::prefix_size + encoded_header_size,
+          encoded_payload_size);
+      sink.header = std::move(header);
+      sink.payload = std::move(payload);
+      ++sink.frames;
+      sink.bytes += sink.header.size() + sink.payload.size();
+      buf_base.erase(0, message_size);
+    }
+
+    if (buf_base.length() > 0) {
+      next_message_.assign(buf_base);
+    }
+  }
+
+private:
+  static int CombineAsciiToInt(std::vector<int> *input) {
+    int result = 0;
+    for (std::string::size_type i = 0; i < input->size(); i++) {
+      if ((*input)[i] < 0) {
+        result = result + pow(256, i) * (256 + (*input)[i]);
+      } else {
+        result = result + pow(256, i) * (*input)[i];
+      }
+    }
+    return result;
+  }
+
+  std::string next_message_;
+};
+
+static void AppendLength(std::string &stream, uint32_t length) {
+  for (int i = 0; i < 4; ++i) {
+    stream += static_cast<char>((length >> (8 * i)) & 0xff);
+  }
+}
+
+// Payload sizes vary around payload_size so that frames straddle the reads
+// at different offsets
+static std::string NewStream(std::size_t total_bytes,
+                             std::size_t payload_size) {
+  std::mt19937 rng(42);
+  std::uniform_int_distribution<std::size_t> dist(payload_size / 2,
+                                                  payload_size * 3 / 2);
+  std::string stream;
+  stream.reserve(total_bytes + payload_size * 2);
+  while (stream.size() < total_bytes) {
+    auto size = dist(rng);
+    AppendLength(stream, HEADER_SIZE);
+    AppendLength(stream, size);
+    stream.append(HEADER_SIZE, 'h');
+    stream.append(size, 'p');
+  }
+  return stream;
+}
+
+template <typename FeedFn>
+static void Run(const char *name, const std::string &stream, FeedFn &&feed,
+                const Sink &sink) {
+  const auto start = std::chrono::steady_clock::now();
+  for (std::size_t offset = 0; offset < stream.size(); offset += READ_SIZE) {
+    feed(stream.data() + offset, std::min(READ_SIZE, stream.size() - offset));
+  }
+  const auto secs = std::chrono::duration<double>(
+                        std::chrono::steady_clock::now() - start)
+                        .count();
+
+  std::cout << name << ": " << sink.frames << " frames, "
+            << static_cast<std::size_t>(stream.size() / secs / (1 << 20))
+            << " MB/s" << std::endl;
+}
+
+int main(int argc, char *argv[]) {
+  const std::size_t total_mb = argc > 1 ? std::atoi(argv[1]) : 256;
+  const std::size_t payload_size = argc > 2 ? std::atoi(argv[2]) : 512;
+  const auto stream = NewStream(total_mb << 20, payload_size);
+
+  Sink legacy_sink;
+  LegacyDecoder legacy;
+  Run("legacy", stream,
+      [&](const char *buf, std::size_t len) {
+        legacy.Feed(buf, static_cast<int>(len), legacy_sink);
+      },
+      legacy_sink);
+
+  Sink sink;
+  FrameDecoder decoder;
+  Run("frame_decoder", stream,
+      [&](const char *buf, std::size_t len) {
+        decoder.Feed(buf, len,
+                     [&sink](const char *frame, uint32_t header_size,
+                             uint32_t payload_size) {
+                       sink.Consume(frame + FrameDecoder::prefix_size,
+                                    header_size, payload_size);
+                     });
+      },
+      sink);
+
+  if (legacy_sink.frames != sink.frames || legacy_sink.bytes != sink.bytes) {
+    std::cerr << "Decoders disagree on the frames decoded" << std::endl;
+    return 1;
+  }
+  return 0;
+}
@@ -1,6 +1,7 @@
 #ifndef CLIENT_H
 #define CLIENT_H
 
+#include <algorithm>
 #include <cassert>
 #include <chrono>
 #include <cstring>
@@ -19,6 +20,7 @@
 #include <uv.h>
 #include <vector>
 
+#include "frame_decoder.h"
 #include "parse_deployment.h"
 #include "v8worker.h"
 
@@ -68,10 +70,12 @@ public:
 
   void OnRead(uv_stream_t *stream, ssize_t nread, const uv_buf_t *buf);
 
-  static std::pair<bool, std::unique_ptr<WorkerMessage>>
-  GetWorkerMessage(int encoded_header_size, int encoded_payload_size,
-                   const std::string &msg);
+  std::pair<bool, std::unique_ptr<WorkerMessage>>
+  GetWorkerMessage(const char *frame, uint32_t encoded_header_size,
+                   uint32_t encoded_payload_size);
   void ParseValidChunk(uv_stream_t *stream, int nread, const char *buf);
+  void ParseFrame(uv_stream_t *stream, const char *frame, uint32_t header_size,
+                  uint32_t payload_size);
 
   void RouteMessageWithResponse(std::unique_ptr<WorkerMessage> worker_msg);
 
@@ -112,10 +116,14 @@ private:
   std::vector<std::unordered_set<int64_t>>
   PartitionVbuckets(const std::vector<int64_t> &vbuckets) const;
 
+  MessagePool *GetMessagePool(uint8_t event, int16_t partition);
+
   void SendPauseAck(const std::unordered_map<int64_t, uint64_t> &lps_map);
 
   std::thread write_responses_thr_;
   std::map<int16_t, V8Worker *> workers_;
+  StartupSnapshot *snapshot_{nullptr};
+  CodeCache *code_cache_{nullptr};
   std::chrono::milliseconds checkpoint_interval_;
 
   Histogram latency_stats_;
@@ -153,7 +161,7 @@ private:
 
   std::string user_prefix_;
 
-  std::string next_message_;
+  FrameDecoder frame_decoder_;
 
   std::string ns_server_port_;
 
@@ -0,0 +1,51 @@
+// Copyright (c) 2019 Couchbase, Inc.
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//     http://www.apache.org/licenses/LICENSE-2.0
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an "AS IS"
+// BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express
+// or implied. See the License for the specific language governing
+// permissions and limitations under the License.
+
+#ifndef CODE_CACHE_H
+#define CODE_CACHE_H
+
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+
+// V8's code cache for the handler script of a function. It's shared by all
+// the V8Workers of the function and persisted to a file, so that respawned
+// consumers skip compilation too. Entries are keyed by a checksum of the
+// final handler code and the V8 version
+class CodeCache {
+public:
+  explicit CodeCache(std::string path);
+
+  CodeCache(const CodeCache &) = delete;
+  CodeCache &operator=(const CodeCache &) = delete;
+
+  // Returns nullptr when there's no cached data for source
+  std::shared_ptr<const std::string> Get(const std::string &source);
+
+  void Put(const std::string &source, const uint8_t *data, int length);
+
+  // To be called when V8 rejects the cached data for source
+  void Invalidate(const std::string &source);
+
+private:
+  std::string GetKey(const std::string &source) const;
+  void LoadLocked();
+  void PersistLocked() const;
+
+  const std::string path_;
+  std::mutex lock_;
+  bool is_loaded_{false};
+  std::string key_;
+  std::shared_ptr<const std::string> data_;
+};
+
+#endif
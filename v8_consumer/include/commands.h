@@ -47,6 +47,9 @@ enum v8_worker_opcode {
 
 enum dcp_opcode { oDelete, oMutation, DCP_Opcode_Unknown };
 
+// Encodings of the DCP metadata in the message header
+enum dcp_header_version { vDcpHeaderJSON = 1, vDcpHeaderTyped };
+
 enum filter_opcode { oVbFilter, oProcessedSeqNo, Filter_Opcode_Unknown };
 
 enum internal_opcode {
@@ -103,6 +106,7 @@ enum v8_worker_config_opcode {
   oLcbExceptions,
   oCurlLatencyStats,
   oCodeInsights,
+  oDcpHeaderVersion,
   V8_Worker_Config_Opcode_Unknown
 };
 
@@ -0,0 +1,65 @@
+// Copyright (c) 2019 Couchbase, Inc.
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//     http://www.apache.org/licenses/LICENSE-2.0
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an "AS IS"
+// BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express
+// or implied. See the License for the specific language governing
+// permissions and limitations under the License.
+
+#ifndef DCP_METADATA_H
+#define DCP_METADATA_H
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <v8.h>
+
+// Fields of the metadata that accompanies every DCP event from Go world
+struct DcpMetadata {
+  uint64_t cas{0};
+  // Raw contents of the JSON string, escape sequences are left as they are
+  std::string_view id;
+  bool id_has_escapes{false};
+  uint32_t expiration{0};
+  uint32_t flags{0};
+  int vb{0};
+  uint64_t seq{0};
+  // Set when the object has exactly the fields above and id has no escapes,
+  // that is, DcpMetaBuilder can stand in for JSON.parse
+  bool is_canonical{false};
+};
+
+// Scans the flat JSON object produced by the Go side's dcpMetadata without
+// allocating. Unknown keys with scalar values are skipped, anything else makes
+// the scan fail so that the caller can fall back to a full JSON parser
+bool ScanDcpMetadata(std::string_view json, DcpMetadata &meta);
+
+// For logging only
+std::string FormatDcpMetadata(const DcpMetadata &meta);
+
+// Builds the meta argument of OnUpdate/OnDelete directly from DcpMetadata. All
+// the objects are instances of one ObjectTemplate and thus share their shape
+class DcpMetaBuilder {
+public:
+  explicit DcpMetaBuilder(v8::Isolate *isolate);
+  ~DcpMetaBuilder();
+
+  DcpMetaBuilder(const DcpMetaBuilder &) = delete;
+  DcpMetaBuilder &operator=(const DcpMetaBuilder &) = delete;
+
+  // Must be called only with canonical DcpMetadata
+  bool Build(const v8::Local<v8::Context> &context, const DcpMetadata &meta,
+             v8::Local<v8::Value> *out) const;
+
+private:
+  enum Field { kCas, kId, kExpiration, kFlags, kVb, kSeq, kNumFields };
+
+  v8::Isolate *isolate_;
+  v8::Persistent<v8::ObjectTemplate> template_;
+  v8::Persistent<v8::String> keys_[kNumFields];
+};
+
+#endif
@@ -0,0 +1,103 @@
+// Copyright (c) 2019 Couchbase, Inc.
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//     http://www.apache.org/licenses/LICENSE-2.0
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an "AS IS"
+// BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express
+// or implied. See the License for the specific language governing
+// permissions and limitations under the License.
+
+#ifndef FRAME_DECODER_H
+#define FRAME_DECODER_H
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Splits the byte stream of the IPC channel into frames. A frame is the
+// uint32 header size and uint32 payload size, both little-endian, followed
+// by the header and the payload. Frames are handed out straight from the
+// buffer being fed, bytes are copied only when a frame straddles two feeds,
+// in which case the trailing fragment is carried over and completed from the
+// head of the next feed
+class FrameDecoder {
+public:
+  static const std::size_t length_size = 4; // uint32
+  static const std::size_t prefix_size = 2 * length_size;
+
+  // Decodes a little-endian uint32 length prefix in place
+  static inline uint32_t DecodeLength(const char *buf) {
+    auto bytes = reinterpret_cast<const unsigned char *>(buf);
+    return static_cast<uint32_t>(bytes[0]) |
+           static_cast<uint32_t>(bytes[1]) << 8 |
+           static_cast<uint32_t>(bytes[2]) << 16 |
+           static_cast<uint32_t>(bytes[3]) << 24;
+  }
+
+  // Calls on_frame(frame, header_size, payload_size) for every frame that's
+  // complete. frame remains valid only for the duration of the call
+  template <typename OnFrame>
+  void Feed(const char *buf, std::size_t len, OnFrame &&on_frame);
+
+  // Drops the incomplete frame carried over, if any
+  void Reset() { partial_frame_.clear(); }
+
+private:
+  std::vector<char> partial_frame_;
+};
+
+template <typename OnFrame>
+void FrameDecoder::Feed(const char *buf, std::size_t len, OnFrame &&on_frame) {
+  auto cursor = buf;
+  auto remaining = len;
+
+  if (!partial_frame_.empty()) {
+    if (partial_frame_.size() < prefix_size) {
+      auto needed = std::min(prefix_size - partial_frame_.size(), remaining);
+      partial_frame_.insert(partial_frame_.end(), cursor, cursor + needed);
+      cursor += needed;
+      remaining -= needed;
+      if (partial_frame_.size() < prefix_size) {
+        return;
+      }
+    }
+
+    auto header_size = DecodeLength(partial_frame_.data());
+    auto payload_size = DecodeLength(partial_frame_.data() + length_size);
+    auto frame_size = prefix_size + header_size + payload_size;
+
+    auto needed = std::min(frame_size - partial_frame_.size(), remaining);
+    partial_frame_.insert(partial_frame_.end(), cursor, cursor + needed);
+    cursor += needed;
+    remaining -= needed;
+    if (partial_frame_.size() < frame_size) {
+      return;
+    }
+
+    on_frame(partial_frame_.data(), header_size, payload_size);
+    // clear() retains the capacity for the next straddling frame
+    partial_frame_.clear();
+  }
+
+  while (remaining >= prefix_size) {
+    auto header_size = DecodeLength(cursor);
+    auto payload_size = DecodeLength(cursor + length_size);
+    auto frame_size = prefix_size + header_size + payload_size;
+    if (remaining < frame_size) {
+      break;
+    }
+
+    on_frame(cursor, header_size, payload_size);
+    cursor += frame_size;
+    remaining -= frame_size;
+  }
+
+  if (remaining > 0) {
+    partial_frame_.assign(cursor, cursor + remaining);
+  }
+}
+
+#endif
@@ -0,0 +1,57 @@
+// Copyright (c) 2019 Couchbase, Inc.
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//     http://www.apache.org/licenses/LICENSE-2.0
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an "AS IS"
+// BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express
+// or implied. See the License for the specific language governing
+// permissions and limitations under the License.
+
+#ifndef MESSAGE_POOL_H
+#define MESSAGE_POOL_H
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+const std::size_t MESSAGE_POOL_MAX_MSGS = 1024;
+const std::size_t MESSAGE_POOL_MAX_BYTES = 16 * 1024 * 1024;
+
+struct WorkerMessage;
+
+// Recycles WorkerMessage objects along with their frame buffers. Each
+// V8Worker owns one pool - messages are acquired by the uv thread when it
+// parses a frame destined for the worker and handed back by the worker once
+// the event has been processed, so only these two threads ever contend
+class MessagePool {
+public:
+  MessagePool(std::size_t max_msgs, std::size_t max_bytes);
+  ~MessagePool();
+
+  MessagePool(const MessagePool &) = delete;
+  MessagePool &operator=(const MessagePool &) = delete;
+
+  std::unique_ptr<WorkerMessage> Acquire();
+  void Release(std::unique_ptr<WorkerMessage> msg);
+
+  int64_t GetHitCount() const { return hits_.load(); }
+  int64_t GetMissCount() const { return misses_.load(); }
+  int64_t GetBytesHeld() const { return bytes_held_.load(); }
+
+private:
+  const std::size_t max_msgs_;
+  const std::size_t max_bytes_;
+
+  std::mutex lock_;
+  std::vector<std::unique_ptr<WorkerMessage>> free_msgs_;
+
+  std::atomic<int64_t> hits_{0};
+  std::atomic<int64_t> misses_{0};
+  std::atomic<int64_t> bytes_held_{0};
+};
+
+#endif
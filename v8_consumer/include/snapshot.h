@@ -0,0 +1,46 @@
+// Copyright (c) 2019 Couchbase, Inc.
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//     http://www.apache.org/licenses/LICENSE-2.0
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an "AS IS"
+// BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express
+// or implied. See the License for the specific language governing
+// permissions and limitations under the License.
+
+#ifndef SNAPSHOT_H
+#define SNAPSHOT_H
+
+#include <cstdint>
+#include <string>
+#include <v8.h>
+#include <vector>
+
+// V8 startup blob which is built once per function and shared by all of its
+// V8Workers. Besides the builtins, it holds a worker context with the eventing
+// globals and error classes installed and a transpiler context in which the
+// transpiler bundle has already been run
+class StartupSnapshot {
+public:
+  enum ContextIndex { kWorkerContext, kTranspilerContext };
+
+  StartupSnapshot(const std::string &transpiler_src,
+                  const std::vector<std::string> &exception_type_names);
+  ~StartupSnapshot();
+
+  StartupSnapshot(const StartupSnapshot &) = delete;
+  StartupSnapshot &operator=(const StartupSnapshot &) = delete;
+
+  bool IsValid() const { return blob_.data != nullptr && blob_.raw_size > 0; }
+
+  // Must be set on the isolate's CreateParams along with GetExternalReferences
+  v8::StartupData *GetBlob() { return &blob_; }
+
+  static const intptr_t *GetExternalReferences();
+
+private:
+  v8::StartupData blob_{nullptr, 0};
+};
+
+#endif
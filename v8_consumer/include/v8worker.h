@@ -29,6 +29,7 @@
 #include <regex>
 #include <sstream>
 #include <string>
+#include <string_view>
 #include <thread>
 #include <unordered_map>
 #include <uv.h>
@@ -37,14 +38,19 @@
 
 #include "blocking_deque.h"
 #include "bucket.h"
+#include "code_cache.h"
 #include "commands.h"
+#include "dcp_metadata.h"
 #include "histogram.h"
 #include "insight.h"
 #include "inspector_agent.h"
 #include "isolate_data.h"
 #include "js_exception.h"
 #include "log.h"
+#include "message_pool.h"
 #include "parse_deployment.h"
+#include "ring_queue.h"
+#include "snapshot.h"
 #include "timer_store.h"
 #include "transpiler.h"
 #include "utils.h"
@@ -59,6 +65,13 @@ typedef std::chrono::nanoseconds nsecs;
 
 #define SECS_TO_NS 1000 * 1000 * 1000ULL
 
+// Slots per lane of the ring queue, both must be powers of 2
+const size_t WORKER_QUEUE_CAPACITY = 128 * 1024;
+const size_t WORKER_QUEUE_PRIORITY_CAPACITY = 1024;
+
+// Upper bound on the number of queued DCP events dispatched under one lock
+const size_t MAX_DCP_BATCH_SIZE = 64;
+
 extern int64_t timer_context_size;
 
 using atomic_ptr_t = std::shared_ptr<std::atomic<uint64_t>>;
@@ -71,54 +84,96 @@ typedef struct timer_msg_s {
   std::string timer_entry;
 } timer_msg_t;
 
-// Header frame structure for messages from Go world
+// Header frame structure for messages from Go world. metadata is a view into
+// the frame buffer owned by the enclosing WorkerMessage
 struct MessageHeader {
   MessageHeader() = default;
   ~MessageHeader() = default;
   MessageHeader(MessageHeader &&other) noexcept
       : event(other.event), opcode(other.opcode), partition(other.partition),
-        metadata(std::move(other.metadata)) {}
+        metadata(other.metadata), dcp_meta(other.dcp_meta),
+        has_typed_meta(other.has_typed_meta) {}
 
   MessageHeader &operator=(MessageHeader &&other) noexcept {
     event = other.event;
     opcode = other.opcode;
     partition = other.partition;
-    metadata = std::move(other.metadata);
+    metadata = other.metadata;
+    dcp_meta = other.dcp_meta;
+    has_typed_meta = other.has_typed_meta;
     return *this;
   }
   MessageHeader(const MessageHeader &other) = delete;
   MessageHeader &operator=(const MessageHeader &other) = delete;
 
+  // For logging only
+  std::string GetMetadataString() const {
+    return has_typed_meta ? FormatDcpMetadata(dcp_meta) : std::string(metadata);
+  }
+
+  // metadata is accounted for by MessagePayload, which owns its bytes
   std::size_t GetSize() const {
-    return metadata.length() + sizeof(event) + sizeof(opcode) +
-           sizeof(partition);
+    return sizeof(event) + sizeof(opcode) + sizeof(partition);
   }
 
   uint8_t event{0};
   uint8_t opcode{0};
   int16_t partition{0};
-  std::string metadata;
+  std::string_view metadata;
+  // Filled in instead of metadata when the DCP event carries typed metadata
+  DcpMetadata dcp_meta;
+  bool has_typed_meta{false};
 };
 
-// Flatbuffer encoded message from Go world
+// Flatbuffer encoded message from Go world. The header and payload of a frame
+// are held in a single allocation and exposed as views into it. The buffer is
+// retained across Assign calls so that pooled messages can reuse it
 struct MessagePayload {
   MessagePayload() = default;
   ~MessagePayload() = default;
   MessagePayload(MessagePayload &&other) noexcept
-      : header(std::move(other.header)), payload(std::move(other.payload)) {}
+      : frame(std::move(other.frame)), frame_capacity(other.frame_capacity),
+        header(other.header), payload(other.payload) {
+    other.frame_capacity = 0;
+  }
 
   MessagePayload &operator=(MessagePayload &&other) noexcept {
-    header = std::move(other.header);
-    payload = std::move(other.payload);
+    frame = std::move(other.frame);
+    frame_capacity = other.frame_capacity;
+    header = other.header;
+    payload = other.payload;
+    other.frame_capacity = 0;
     return *this;
   }
   MessagePayload(const MessagePayload &other) = delete;
   MessagePayload &operator=(const MessagePayload &other) = delete;
 
-  std::size_t GetSize() const { return header.length() + payload.length(); }
+  // Copies the header and payload out of the wire frame. The payload is
+  // placed at an 8 byte aligned offset so that its flatbuffer scalars can be
+  // read in place
+  void Assign(const char *header_start, std::size_t header_size,
+              const char *payload_start, std::size_t payload_size) {
+    const auto payload_offset = (header_size + 7) & ~std::size_t(7);
+    const auto frame_size = payload_offset + payload_size;
+    if (frame_size > frame_capacity) {
+      frame.reset(new char[frame_size]);
+      frame_capacity = frame_size;
+    }
+    std::memcpy(frame.get(), header_start, header_size);
+    std::memcpy(frame.get() + payload_offset, payload_start, payload_size);
+    header = std::string_view(frame.get(), header_size);
+    payload = std::string_view(frame.get() + payload_offset, payload_size);
+  }
+
+  // Reports the memory held rather than the length of the current frame
+  std::size_t GetSize() const { return frame_capacity; }
+
+  std::size_t GetLength() const { return header.length() + payload.length(); }
 
-  std::string header;
-  std::string payload;
+  std::unique_ptr<char[]> frame;
+  std::size_t frame_capacity{0};
+  std::string_view header;
+  std::string_view payload;
 };
 
 // Struct to contain flatbuffer decoded message from Go world
@@ -142,6 +197,8 @@ struct WorkerMessage {
   MessagePayload payload;
 };
 
+using WorkerMessageBatch = std::vector<std::unique_ptr<WorkerMessage>>;
+
 typedef struct server_settings_s {
   int checkpoint_interval;
   std::string debugger_port;
@@ -153,12 +210,20 @@ typedef struct server_settings_s {
 
 typedef struct handler_config_s {
   bool n1ql_prepare_all;
+  bool pipeline_bucket_writes;
   std::string app_name;
   std::string dep_cfg;
   std::string lang_compat;
   int execution_timeout;
   int lcb_retry_count;
   int lcb_inst_capacity;
+  int n1ql_min_connections;
+  int n1ql_prefetch_rows;
+  int n1ql_prefetch_bytes;
+  int bucket_cache_size;
+  int bucket_cache_age;
+  bool bucket_cache_parsed_docs;
+  int bucket_op_timeout;
   bool skip_lcb_bootstrap;
   bool using_timer;
   int64_t timer_context_size;
@@ -196,6 +261,7 @@ extern std::atomic<int64_t> on_delete_failure;
 extern std::atomic<int64_t> timer_create_failure;
 
 extern std::atomic<int64_t> lcb_retry_failure;
+extern std::atomic<int64_t> bucket_op_pipelined_writes;
 
 extern std::atomic<int64_t> messages_processed_counter;
 extern std::atomic<int64_t> processed_events_size;
@@ -215,6 +281,30 @@ extern std::atomic<int64_t> filtered_dcp_delete_counter;
 extern std::atomic<int64_t> filtered_dcp_mutation_counter;
 extern std::atomic<int64_t> enqueued_timer_msg_counter;
 
+// Handler compilation, aggregated over all the workers
+extern std::atomic<int64_t> script_compile_time_us;
+extern std::atomic<int64_t> code_cache_hit;
+extern std::atomic<int64_t> code_cache_miss;
+extern std::atomic<int64_t> code_cache_rejected;
+
+// Time spent in each phase of bringing up the workers, aggregated over all of
+// them. The workers are brought up in parallel, so these add up to more than
+// the wall clock time
+extern std::atomic<int64_t> init_isolate_time_us;
+extern std::atomic<int64_t> init_context_time_us;
+extern std::atomic<int64_t> init_lcb_connect_time_us;
+extern std::atomic<int64_t> load_failure_count;
+
+// Same as above, for a single worker
+struct WorkerInitStats {
+  int64_t isolate_time_us{0};
+  int64_t context_time_us{0};
+  int64_t lcb_connect_time_us{0};
+  int64_t compile_time_us{0};
+  bool is_loaded{false};
+  int load_status{kSuccess};
+};
+
 class V8Worker {
 public:
   V8Worker(v8::Platform *platform, handler_config_t *h_config,
@@ -222,15 +312,20 @@ public:
            const std::string &function_id,
            const std::string &function_instance_id,
            const std::string &user_prefix, Histogram *latency_stats,
-           Histogram *curl_latency_stats, const std::string &ns_server_port);
+           Histogram *curl_latency_stats, const std::string &ns_server_port,
+           StartupSnapshot *snapshot = nullptr,
+           CodeCache *code_cache = nullptr);
   ~V8Worker();
 
-  int V8WorkerLoad(std::string source_s);
+  // The transpiled handler is the same for all the workers of a function, so
+  // it can be produced by any one of them and loaded into the rest
+  std::string TranspileHandler(const std::string &handler);
+  int LoadTranspiledHandler(std::string script_to_execute);
   void RouteMessage();
   void TaskDurationWatcher();
 
-  int SendUpdate(const std::string &value, const std::string &meta);
-  int SendDelete(const std::string &meta);
+  int SendUpdate(std::string_view value, const MessageHeader &header);
+  int SendDelete(const MessageHeader &header);
   void SendTimer(std::string callback, std::string timer_ctx);
   std::string CompileHandler(std::string handler);
   CodeVersion IdentifyVersion(std::string handler);
@@ -266,9 +361,9 @@ public:
 
   std::unique_lock<std::mutex> GetAndLockFilterLock();
 
-  int ParseMetadata(const std::string &metadata, int &vb_no,
+  int ParseMetadata(std::string_view metadata, int &vb_no,
                     uint64_t &seq_no) const;
-  int ParseMetadataWithAck(const std::string &metadata_str, int &vb_no,
+  int ParseMetadataWithAck(std::string_view metadata_str, int &vb_no,
                            uint64_t &seq_no, int &skip_ack,
                            bool ack_check) const;
 
@@ -290,10 +385,22 @@ public:
 
   inline std::string GetFunctionInstanceID() { return function_instance_id_; }
 
+  nsecs GetRemainingExecutionTime() const;
+
   v8::Isolate *GetIsolate() { return isolate_; }
+
+  static std::vector<std::string> GetExceptionTypeNames() {
+    return {"KVError", "N1QLError", "EventingError", "CurlError"};
+  }
+
+  static v8::Local<v8::ObjectTemplate>
+  NewGlobalObj(v8::Isolate *isolate,
+               const std::vector<std::string> &exception_type_names);
   v8::Persistent<v8::Context> context_;
   v8::Persistent<v8::Function> on_update_;
   v8::Persistent<v8::Function> on_delete_;
+  v8::Persistent<v8::Function> on_update_batch_;
+  v8::Persistent<v8::Function> on_delete_batch_;
 
   std::string app_name_;
   std::string script_to_execute_;
@@ -312,7 +419,10 @@ public:
 
   std::thread processing_thr_;
   std::thread *terminator_thr_;
-  BlockingDeque<std::unique_ptr<WorkerMessage>> *worker_queue_;
+  MessageQueue<std::unique_ptr<WorkerMessage>> *worker_queue_;
+  MessagePool *message_pool_;
+  DcpMetaBuilder *meta_builder_{nullptr};
+  WorkerInitStats init_stats_;
 
   size_t v8_heap_size_;
   std::mutex lcb_exception_mtx_;
@@ -321,17 +431,30 @@ public:
 
 private:
   void UpdateSeqNumLocked(int vb, uint64_t seq_num);
+  void HandleDCPBatch(const WorkerMessageBatch &batch);
+  bool IsBatchHandlerDefined(dcp_opcode opcode) const;
+  void HandleEventRun(WorkerMessageBatch::const_iterator begin,
+                      WorkerMessageBatch::const_iterator end,
+                      dcp_opcode opcode);
+  int SendUpdateBatch(const std::vector<const WorkerMessage *> &events);
+  int SendDeleteBatch(const std::vector<const WorkerMessage *> &events);
+  bool WrapInArrays(const v8::Local<v8::Context> &context,
+                    v8::Local<v8::Value> *args, int args_len) const;
   void HandleDeleteEvent(const std::unique_ptr<WorkerMessage> &msg);
   void HandleMutationEvent(const std::unique_ptr<WorkerMessage> &msg);
   bool IsFilteredEventLocked(int vb, uint64_t seq_num);
   std::tuple<int, uint64_t, bool>
   GetVbAndSeqNum(const std::unique_ptr<WorkerMessage> &msg) const;
-  v8::Local<v8::ObjectTemplate> NewGlobalObj() const;
+  bool NewMetaObject(const v8::Local<v8::Context> &context,
+                     const MessageHeader &header,
+                     v8::Local<v8::Value> *out) const;
   void InstallCurlBindings(const std::vector<CurlBinding> &curl_bindings) const;
   void InstallBucketBindings(
       const std::unordered_map<
           std::string,
           std::unordered_map<std::string, std::vector<std::string>>> &config);
+  void FlushBucketWrites();
+  void FlushBucketWrites(const Bucket *reader);
   void InitializeIsolateData(const server_settings_t *server_settings,
                              const handler_config_t *h_config,
                              const std::string &source_bucket);
@@ -363,9 +486,11 @@ private:
   std::string function_instance_id_;
   std::string user_prefix_;
   std::string ns_server_port_;
+  CodeCache *code_cache_;
   timer::TimerStore *timer_store_{nullptr};
   std::atomic<bool> thread_exit_cond_;
   const std::vector<std::string> exception_type_names_;
+  bool is_context_from_snapshot_{false};
   std::vector<std::string> curl_binding_values_;
   std::atomic<bool> stop_timer_scan_;
   std::unordered_set<int64_t> partitions_;
@@ -10,11 +10,13 @@
 // permissions and limitations under the License.
 
 #include <chrono>
+#include <functional>
 #include <string>
 #include <thread>
 
 #include "breakpad.h"
 #include "client.h"
+#include "conn-pool.h"
 #include <nlohmann/json.hpp>
 
 uint64_t timer_responses_sent(0);
@@ -81,6 +83,25 @@ std::string GetExecutionStats(const std::map<int16_t, V8Worker *> &workers) {
   estats["timer_responses_sent"] = timer_responses_sent;
   estats["uv_try_write_failure_counter"] = uv_try_write_failure_counter.load();
   estats["lcb_retry_failure"] = lcb_retry_failure.load();
+  estats["lcb_retry_attempts"] = lcb_retry_attempts.load();
+  estats["lcb_retry_time_us"] = lcb_retry_time_us.load();
+  estats["bucket_op_pipelined_writes"] = bucket_op_pipelined_writes.load();
+  estats["bucket_cache"]["hit"] = bucket_cache_hit.load();
+  estats["bucket_cache"]["miss"] = bucket_cache_miss.load();
+  estats["bucket_cache"]["eviction"] = bucket_cache_eviction.load();
+  estats["bucket_cache"]["parsed_hit"] = parsed_doc_cache_hit.load();
+  estats["bucket_cache"]["parsed_miss"] = parsed_doc_cache_miss.load();
+  estats["kv_nodes_cache"]["age_ms"] = Communicator::GetKVNodesCacheAge();
+  estats["kv_nodes_cache"]["refresh_count"] = kv_nodes_refresh_count.load();
+  estats["kv_nodes_cache"]["refresh_failure"] =
+      kv_nodes_refresh_failure.load();
+  estats["kv_nodes_cache"]["refresh_latency_us"] =
+      kv_nodes_refresh_latency_us.load();
+  estats["n1ql_pool"]["conn_create_count"] = n1ql_conn_create_count.load();
+  estats["n1ql_pool"]["conn_create_failure"] = n1ql_conn_create_failure.load();
+  estats["n1ql_pool"]["conn_create_time_us"] = n1ql_conn_create_time_us.load();
+  estats["n1ql_pool"]["conn_discarded"] = n1ql_conn_discarded.load();
+  estats["n1ql_pool"]["wait_time_us"] = n1ql_pool_wait_time_us.load();
   estats["dcp_delete_parse_failure"] = dcp_delete_parse_failure.load();
   estats["dcp_mutation_parse_failure"] = dcp_mutation_parse_failure.load();
   estats["filtered_dcp_delete_counter"] = filtered_dcp_delete_counter.load();
@@ -88,9 +109,14 @@ std::string GetExecutionStats(const std::map<int16_t, V8Worker *> &workers) {
       filtered_dcp_mutation_counter.load();
   if (!workers.empty()) {
     int64_t agg_queue_memory = 0, agg_queue_size = 0;
+    int64_t pool_hit = 0, pool_miss = 0, pool_bytes_held = 0;
     for (const auto &w : workers) {
       agg_queue_size += w.second->worker_queue_->GetSize();
       agg_queue_memory += w.second->worker_queue_->GetMemory();
+      agg_queue_memory += w.second->message_pool_->GetBytesHeld();
+      pool_hit += w.second->message_pool_->GetHitCount();
+      pool_miss += w.second->message_pool_->GetMissCount();
+      pool_bytes_held += w.second->message_pool_->GetBytesHeld();
     }
 
     estats["agg_queue_size"] = agg_queue_size;
@@ -98,6 +124,9 @@ std::string GetExecutionStats(const std::map<int16_t, V8Worker *> &workers) {
     estats["agg_queue_memory"] = agg_queue_memory;
     estats["processed_events_size"] = processed_events_size.load();
     estats["num_processed_events"] = num_processed_events.load();
+    estats["message_pool"]["hit"] = pool_hit;
+    estats["message_pool"]["miss"] = pool_miss;
+    estats["message_pool"]["bytes_held"] = pool_bytes_held;
   }
   estats["curl"]["get"] = Curl::GetStats().GetCurlGetStat();
   estats["curl"]["post"] = Curl::GetStats().GetCurlPostStat();
@@ -106,6 +135,25 @@ std::string GetExecutionStats(const std::map<int16_t, V8Worker *> &workers) {
   estats["curl"]["put"] = Curl::GetStats().GetCurlPutStat();
   estats["timestamp"] = GetTimestampNow();
   estats["uv_msg_parse_failure"] = uv_msg_parse_failure.load();
+  estats["startup"]["script_compile_time_us"] = script_compile_time_us.load();
+  estats["startup"]["isolate_time_us"] = init_isolate_time_us.load();
+  estats["startup"]["context_time_us"] = init_context_time_us.load();
+  estats["startup"]["lcb_connect_time_us"] = init_lcb_connect_time_us.load();
+  estats["startup"]["load_failure_count"] = load_failure_count.load();
+  for (const auto &w : workers) {
+    const auto &init_stats = w.second->init_stats_;
+    auto &worker_stats = estats["startup"]["workers"][std::to_string(w.first)];
+    worker_stats["isolate_time_us"] = init_stats.isolate_time_us;
+    worker_stats["context_time_us"] = init_stats.context_time_us;
+    worker_stats["lcb_connect_time_us"] = init_stats.lcb_connect_time_us;
+    worker_stats["compile_time_us"] = init_stats.compile_time_us;
+    if (init_stats.is_loaded) {
+      worker_stats["load_status"] = init_stats.load_status;
+    }
+  }
+  estats["code_cache"]["hit"] = code_cache_hit.load();
+  estats["code_cache"]["miss"] = code_cache_miss.load();
+  estats["code_cache"]["rejected"] = code_cache_rejected.load();
   return estats.dump();
 }
 
@@ -123,48 +171,99 @@ static void alloc_buffer_feedback(uv_handle_t *handle, size_t suggested_size,
   *buf = uv_buf_init(read_buffer->data(), read_buffer->capacity());
 }
 
-int combineAsciiToInt(std::vector<int> *input) {
-  int result = 0;
-  for (std::string::size_type i = 0; i < input->size(); i++) {
-    if ((*input)[i] < 0) {
-      result = result + pow(256, i) * (256 + (*input)[i]);
-    } else {
-      result = result + pow(256, i) * (*input)[i];
-    }
+// Runs fn for each index in [begin, end) on a few threads, bounded by the
+// number of cores
+static void ParallelFor(int16_t begin, int16_t end,
+                        const std::function<void(int16_t)> &fn) {
+  if (begin >= end) {
+    return;
+  }
+
+  const auto thr_count = std::min<unsigned>(
+      end - begin, std::max(1u, std::thread::hardware_concurrency()));
+  std::atomic<int16_t> next(begin);
+  std::vector<std::thread> thrs;
+  for (unsigned i = 0; i < thr_count; ++i) {
+    thrs.emplace_back([&next, end, &fn]() {
+      for (auto index = next++; index < end; index = next++) {
+        fn(index);
+      }
+    });
+  }
+  for (auto &thr : thrs) {
+    thr.join();
   }
-  return result;
 }
 
 std::pair<bool, std::unique_ptr<WorkerMessage>>
-AppWorker::GetWorkerMessage(int encoded_header_size, int encoded_payload_size,
-                            const std::string &msg) {
+AppWorker::GetWorkerMessage(const char *frame, uint32_t encoded_header_size,
+                            uint32_t encoded_payload_size) {
   messages_parsed++;
-  std::unique_ptr<WorkerMessage> worker_msg(new WorkerMessage);
 
-  // Parsing payload
-  worker_msg->payload.header = msg.substr(
-      HEADER_FRAGMENT_SIZE + PAYLOAD_FRAGMENT_SIZE, encoded_header_size);
-  worker_msg->payload.payload = msg.substr(
-      HEADER_FRAGMENT_SIZE + PAYLOAD_FRAGMENT_SIZE + encoded_header_size,
-      encoded_payload_size);
-
-  // Parsing header
-  const MessagePayload &payload = worker_msg->payload;
-  auto header_flatbuf = flatbuf::header::GetHeader(payload.header.c_str());
+  // Verify the header in place, it decides which worker's pool the message
+  // is drawn from
+  auto header_start = frame + HEADER_FRAGMENT_SIZE + PAYLOAD_FRAGMENT_SIZE;
+  auto header_flatbuf = flatbuf::header::GetHeader(header_start);
   auto verifier = flatbuffers::Verifier(
-      reinterpret_cast<const uint8_t *>(payload.header.c_str()),
-      payload.header.size());
+      reinterpret_cast<const uint8_t *>(header_start), encoded_header_size);
 
   if (!header_flatbuf->Verify(verifier)) {
-    return {false, std::move(worker_msg)};
+    return {false, nullptr};
   }
+
+  auto pool = GetMessagePool(header_flatbuf->event(),
+                             header_flatbuf->partition());
+  auto worker_msg = pool != nullptr
+                        ? pool->Acquire()
+                        : std::unique_ptr<WorkerMessage>(new WorkerMessage);
+
+  // Parsing payload
+  worker_msg->payload.Assign(header_start, encoded_header_size,
+                             header_start + encoded_header_size,
+                             encoded_payload_size);
+
+  // Parsing header
+  const MessagePayload &payload = worker_msg->payload;
+  header_flatbuf = flatbuf::header::GetHeader(payload.header.data());
   worker_msg->header.event = header_flatbuf->event();
   worker_msg->header.opcode = header_flatbuf->opcode();
   worker_msg->header.partition = header_flatbuf->partition();
-  worker_msg->header.metadata = header_flatbuf->metadata()->str();
+  if (auto metadata = header_flatbuf->metadata()) {
+    worker_msg->header.metadata =
+        std::string_view(metadata->c_str(), metadata->size());
+  }
+  if (auto key = header_flatbuf->key()) {
+    auto &meta = worker_msg->header.dcp_meta;
+    meta.cas = header_flatbuf->cas();
+    meta.id = std::string_view(reinterpret_cast<const char *>(key->data()),
+                               key->size());
+    meta.expiration = header_flatbuf->expiry();
+    meta.flags = header_flatbuf->flags();
+    meta.vb = header_flatbuf->vb();
+    meta.seq = header_flatbuf->seq();
+    meta.is_canonical = true;
+    worker_msg->header.has_typed_meta = true;
+  }
   return {true, std::move(worker_msg)};
 }
 
+MessagePool *AppWorker::GetMessagePool(uint8_t event, int16_t partition) {
+  if (getEvent(event) != eDCP) {
+    return nullptr;
+  }
+
+  auto thr = partition_thr_map_.find(partition);
+  if (thr == partition_thr_map_.end()) {
+    return nullptr;
+  }
+
+  auto worker = workers_.find(thr->second);
+  if (worker == workers_.end() || worker->second == nullptr) {
+    return nullptr;
+  }
+  return worker->second->message_pool_;
+}
+
 AppWorker *AppWorker::GetAppWorker() {
   static AppWorker worker;
   return &worker;
@@ -307,140 +406,109 @@ void AppWorker::OnRead(uv_stream_t *stream, ssize_t nread,
   if (nread > 0) {
     AppWorker::GetAppWorker()->ParseValidChunk(stream, nread, buf->base);
   } else if (nread == 0) {
-    next_message_.clear();
+    frame_decoder_.Reset();
   } else {
     if (nread != UV_EOF) {
       LOG(logError) << "Read error, err code: " << uv_err_name(nread)
                     << std::endl;
     }
-    AppWorker::GetAppWorker()->ParseValidChunk(stream, next_message_.length(),
-                                               next_message_.c_str());
-    next_message_.clear();
+    // Whatever is left over is an incomplete frame and can't be parsed
+    frame_decoder_.Reset();
     uv_read_stop(stream);
   }
 }
 
+// Frames are decoded straight out of the buffer handed over by libuv
 void AppWorker::ParseValidChunk(uv_stream_t *stream, int nread,
                                 const char *buf) {
-  std::string buf_base;
-  for (int i = 0; i < nread; i++) {
-    buf_base += buf[i];
-  }
-
-  if (next_message_.length() > 0) {
-    buf_base = next_message_ + buf_base;
-    next_message_.clear();
-  }
-
-  for (; buf_base.length() > HEADER_FRAGMENT_SIZE + PAYLOAD_FRAGMENT_SIZE;) {
-    std::vector<int> header_entries, payload_entries;
-    int encoded_header_size, encoded_payload_size;
-
-    for (int i = 0; i < HEADER_FRAGMENT_SIZE; i++) {
-      header_entries.push_back(int(buf_base[i]));
-    }
-    encoded_header_size = combineAsciiToInt(&header_entries);
+  frame_decoder_.Feed(buf, static_cast<size_t>(nread),
+                      [this, stream](const char *frame, uint32_t header_size,
+                                     uint32_t payload_size) {
+                        ParseFrame(stream, frame, header_size, payload_size);
+                      });
+}
 
-    for (int i = HEADER_FRAGMENT_SIZE;
-         i < HEADER_FRAGMENT_SIZE + PAYLOAD_FRAGMENT_SIZE; i++) {
-      payload_entries.push_back(int(buf_base[i]));
+void AppWorker::ParseFrame(uv_stream_t *stream, const char *frame,
+                           uint32_t header_size, uint32_t payload_size) {
+  auto worker_msg = GetWorkerMessage(frame, header_size, payload_size);
+  if (!worker_msg.first) {
+    ++uv_msg_parse_failure;
+    // We only need to know the first message which failed to parse as the
+    // subsequent messages will fail to get parsed anyway
+    if (uv_msg_parse_failure == 1) {
+      std::string frame_contents(frame, HEADER_FRAGMENT_SIZE +
+                                            PAYLOAD_FRAGMENT_SIZE +
+                                            header_size + payload_size);
+      LOG(logError)
+          << "Failed to parse message from uv buffer. Buffer contents : "
+          << RU(frame_contents) << std::endl;
     }
-    encoded_payload_size = combineAsciiToInt(&payload_entries);
-
-    std::string::size_type message_size =
-        HEADER_FRAGMENT_SIZE + PAYLOAD_FRAGMENT_SIZE + encoded_header_size +
-        encoded_payload_size;
-
-    if (buf_base.length() < message_size) {
-      next_message_.assign(buf_base);
-      return;
-    } else {
-      std::string chunk_to_parse = buf_base.substr(0, message_size);
-
-      auto worker_msg = GetWorkerMessage(encoded_header_size,
-                                         encoded_payload_size, chunk_to_parse);
-      if (worker_msg.first) {
-        RouteMessageWithResponse(std::move(worker_msg.second));
-
-        if (messages_processed_counter >= batch_size_ || msg_priority_) {
+    return;
+  }
 
-          messages_processed_counter = 0;
+  RouteMessageWithResponse(std::move(worker_msg.second));
 
-          // Reset the message priority flag
-          msg_priority_ = false;
-          if (!resp_msg_->msg.empty()) {
-            flatbuffers::FlatBufferBuilder builder;
+  if (messages_processed_counter >= batch_size_ || msg_priority_) {
+    messages_processed_counter = 0;
 
-            auto flatbuf_msg = builder.CreateString(resp_msg_->msg.c_str());
-            auto r = flatbuf::response::CreateResponse(
-                builder, resp_msg_->msg_type, resp_msg_->opcode, flatbuf_msg);
-            builder.Finish(r);
+    // Reset the message priority flag
+    msg_priority_ = false;
+    if (!resp_msg_->msg.empty()) {
+      flatbuffers::FlatBufferBuilder builder;
 
-            uint32_t s = builder.GetSize();
-            char *size = (char *)&s;
-            FlushToConn(stream, size, SIZEOF_UINT32);
+      auto flatbuf_msg = builder.CreateString(resp_msg_->msg.c_str());
+      auto r = flatbuf::response::CreateResponse(
+          builder, resp_msg_->msg_type, resp_msg_->opcode, flatbuf_msg);
+      builder.Finish(r);
 
-            // Write payload to socket
-            std::string msg((const char *)builder.GetBufferPointer(),
-                            builder.GetSize());
-            FlushToConn(stream, (char *)msg.c_str(), msg.length());
+      uint32_t s = builder.GetSize();
+      char *size = (char *)&s;
+      FlushToConn(stream, size, SIZEOF_UINT32);
 
-            // Reset the values
-            resp_msg_->msg.clear();
-            resp_msg_->msg_type = 0;
-            resp_msg_->opcode = 0;
-          }
+      // Write payload to socket
+      std::string msg((const char *)builder.GetBufferPointer(),
+                      builder.GetSize());
+      FlushToConn(stream, (char *)msg.c_str(), msg.length());
 
-          // Flush the aggregate item count in queues for all running
-          // V8 worker instances
-          if (!workers_.empty()) {
-            int64_t agg_queue_size = 0, agg_queue_memory = 0;
-            for (const auto &w : workers_) {
-              agg_queue_size += w.second->worker_queue_->GetSize();
-              agg_queue_memory += w.second->worker_queue_->GetMemory();
-            }
+      // Reset the values
+      resp_msg_->msg.clear();
+      resp_msg_->msg_type = 0;
+      resp_msg_->opcode = 0;
+    }
 
-            std::ostringstream queue_stats;
-            queue_stats << R"({"agg_queue_size":)";
-            queue_stats << agg_queue_size << R"(, "feedback_queue_size":)";
-            queue_stats << 0 << R"(, "agg_queue_memory":)";
-            queue_stats << agg_queue_memory << R"(, "processed_events_size":)";
-            queue_stats << processed_events_size
-                        << R"(, "num_processed_events":)";
-            queue_stats << num_processed_events << "}";
-
-            flatbuffers::FlatBufferBuilder builder;
-            auto flatbuf_msg = builder.CreateString(queue_stats.str());
-            auto r = flatbuf::response::CreateResponse(
-                builder, mV8_Worker_Config, oQueueSize, flatbuf_msg);
-            builder.Finish(r);
-
-            uint32_t s = builder.GetSize();
-            char *size = (char *)&s;
-            FlushToConn(stream, size, SIZEOF_UINT32);
-
-            // Write payload to socket
-            std::string msg((const char *)builder.GetBufferPointer(),
-                            builder.GetSize());
-            FlushToConn(stream, (char *)msg.c_str(), msg.length());
-          }
-        }
-      } else {
-        ++uv_msg_parse_failure;
-        // We only need to know the first message which failed to parse as the
-        // subsequent messages will fail to get parsed anyway
-        if (uv_msg_parse_failure == 1) {
-          LOG(logError)
-              << "Failed to parse message from uv buffer. Buffer contents : "
-              << RU(buf_base) << std::endl;
-        }
+    // Flush the aggregate item count in queues for all running
+    // V8 worker instances
+    if (!workers_.empty()) {
+      int64_t agg_queue_size = 0, agg_queue_memory = 0;
+      for (const auto &w : workers_) {
+        agg_queue_size += w.second->worker_queue_->GetSize();
+        agg_queue_memory += w.second->worker_queue_->GetMemory();
+        agg_queue_memory += w.second->message_pool_->GetBytesHeld();
       }
-    }
-    buf_base.erase(0, message_size);
-  }
 
-  if (buf_base.length() > 0) {
-    next_message_.assign(buf_base);
+      std::ostringstream queue_stats;
+      queue_stats << R"({"agg_queue_size":)";
+      queue_stats << agg_queue_size << R"(, "feedback_queue_size":)";
+      queue_stats << 0 << R"(, "agg_queue_memory":)";
+      queue_stats << agg_queue_memory << R"(, "processed_events_size":)";
+      queue_stats << processed_events_size << R"(, "num_processed_events":)";
+      queue_stats << num_processed_events << "}";
+
+      flatbuffers::FlatBufferBuilder builder;
+      auto flatbuf_msg = builder.CreateString(queue_stats.str());
+      auto r = flatbuf::response::CreateResponse(
+          builder, mV8_Worker_Config, oQueueSize, flatbuf_msg);
+      builder.Finish(r);
+
+      uint32_t s = builder.GetSize();
+      char *size = (char *)&s;
+      FlushToConn(stream, size, SIZEOF_UINT32);
+
+      // Write payload to socket
+      std::string msg((const char *)builder.GetBufferPointer(),
+                      builder.GetSize());
+      FlushToConn(stream, (char *)msg.c_str(), msg.length());
+    }
   }
 }
 
@@ -472,7 +540,7 @@ void AppWorker::FlushToConn(uv_stream_t *stream, char *msg, int length) {
 
 void AppWorker::RouteMessageWithResponse(
     std::unique_ptr<WorkerMessage> worker_msg) {
-  std::string key, val, doc_id, callback_fn, doc_ids_cb_fns, compile_resp;
+  std::string key, doc_id, callback_fn, doc_ids_cb_fns, compile_resp;
   v8::Platform *platform;
   server_settings_t *server_settings;
   handler_config_t *handler_config;
@@ -496,12 +564,14 @@ void AppWorker::RouteMessageWithResponse(
     case oDispose:
     case oInit:
       payload = flatbuf::payload::GetPayload(
-          (const void *)worker_msg->payload.payload.c_str());
+          (const void *)worker_msg->payload.payload.data());
 
       handler_config = new handler_config_t;
       server_settings = new server_settings_t;
 
       handler_config->n1ql_prepare_all = payload->n1ql_prepare_all();
+      handler_config->pipeline_bucket_writes =
+          payload->pipeline_bucket_writes();
       handler_config->app_name.assign(payload->app_name()->str());
       handler_config->lang_compat.assign(
           payload->language_compatibility()->str());
@@ -509,6 +579,14 @@ void AppWorker::RouteMessageWithResponse(
       handler_config->dep_cfg.assign(payload->depcfg()->str());
       handler_config->execution_timeout = payload->execution_timeout();
       handler_config->lcb_retry_count = payload->lcb_retry_count();
+      handler_config->bucket_cache_size = payload->bucket_cache_size();
+      handler_config->bucket_cache_age = payload->bucket_cache_age();
+      handler_config->bucket_cache_parsed_docs =
+          payload->bucket_cache_parsed_docs();
+      handler_config->bucket_op_timeout = payload->bucket_op_timeout();
+      handler_config->n1ql_min_connections = payload->n1ql_min_connections();
+      handler_config->n1ql_prefetch_rows = payload->n1ql_prefetch_rows();
+      handler_config->n1ql_prefetch_bytes = payload->n1ql_prefetch_bytes();
       handler_config->lcb_inst_capacity = payload->lcb_inst_capacity();
       handler_config->n1ql_consistency = payload->n1ql_consistency()->str();
       handler_config->skip_lcb_bootstrap = payload->skip_lcb_bootstrap();
@@ -540,17 +618,44 @@ void AppWorker::RouteMessageWithResponse(
       v8::V8::InitializePlatform(platform);
       v8::V8::Initialize();
 
+      code_cache_ = new CodeCache(server_settings->eventing_dir + "/" +
+                                  handler_config->app_name + ".code_cache");
+
+      // Setting CB_EVENTING_NO_SNAPSHOT in the environment makes the workers
+      // build their contexts from scratch
+      if (std::getenv("CB_EVENTING_NO_SNAPSHOT") == nullptr) {
+        snapshot_ = new StartupSnapshot(GetTranspilerSrc(),
+                                        V8Worker::GetExceptionTypeNames());
+        if (!snapshot_->IsValid()) {
+          LOG(logError) << "Unable to create startup snapshot" << std::endl;
+        }
+      }
+
+      // Process-wide, so it's set once here rather than by each worker
+      timer_context_size = handler_config->timer_context_size;
+
       {
-        std::lock_guard<std::mutex> lck(workers_map_mutex_);
-        for (int16_t i = 0; i < thr_count_; i++) {
-          V8Worker *w = new V8Worker(
+        // The workers don't share any unsynchronised state while being
+        // constructed, so they're brought up in parallel
+        const auto start_time = Time::now();
+        std::vector<V8Worker *> workers(thr_count_, nullptr);
+        ParallelFor(0, thr_count_, [&](int16_t index) {
+          workers[index] = new V8Worker(
               platform, handler_config, server_settings, function_name_,
               function_id_, handler_instance_id, user_prefix_, &latency_stats_,
-              &curl_latency_stats_, ns_server_port_);
+              &curl_latency_stats_, ns_server_port_, snapshot_, code_cache_);
+        });
+        LOG(logInfo) << "Initialised " << thr_count_ << " V8Workers in "
+                     << std::chrono::duration_cast<std::chrono::milliseconds>(
+                            Time::now() - start_time)
+                            .count()
+                     << "ms" << std::endl;
 
-          LOG(logInfo) << "Init index: " << i << " V8Worker: " << w
+        std::lock_guard<std::mutex> lck(workers_map_mutex_);
+        for (int16_t i = 0; i < thr_count_; i++) {
+          LOG(logInfo) << "Init index: " << i << " V8Worker: " << workers[i]
                        << std::endl;
-          workers_[i] = w;
+          workers_[i] = workers[i];
         }
 
         delete handler_config;
@@ -558,18 +663,47 @@ void AppWorker::RouteMessageWithResponse(
         msg_priority_ = true;
         v8worker_init_done_ = true;
       }
+
+      // Producers that predate typed DCP headers leave the version unset and
+      // keep sending JSON metadata
+      if (payload->dcp_header_version() > 0) {
+        resp_msg_->msg = std::to_string(
+            std::min<int32_t>(payload->dcp_header_version(), vDcpHeaderTyped));
+        resp_msg_->msg_type = mV8_Worker_Config;
+        resp_msg_->opcode = oDcpHeaderVersion;
+      }
       break;
-    case oLoad:
+    case oLoad: {
       LOG(logDebug) << "Loading app code:" << RM(worker_msg->header.metadata)
                     << std::endl;
-      for (int16_t i = 0; i < thr_count_; i++) {
-        workers_[i]->V8WorkerLoad(worker_msg->header.metadata);
+      if (workers_.empty()) {
+        break;
+      }
 
-        LOG(logInfo) << "Load index: " << i << " V8Worker: " << workers_[i]
+      // Transpiled just once as the result is the same for all the workers
+      const auto script = workers_[0]->TranspileHandler(
+          std::string(worker_msg->header.metadata));
+
+      // The first worker fills the code cache, which the rest then consume
+      // while loading in parallel
+      auto load = [this, &script](int16_t index) {
+        auto worker = workers_.at(index);
+        const auto status = worker->LoadTranspiledHandler(script);
+        worker->init_stats_.is_loaded = true;
+        worker->init_stats_.load_status = status;
+        if (status != kSuccess) {
+          ++load_failure_count;
+          LOG(logError) << "Load index: " << index << " V8Worker: " << worker
+                        << " failed with status: " << status << std::endl;
+          return;
+        }
+        LOG(logInfo) << "Load index: " << index << " V8Worker: " << worker
                      << std::endl;
-      }
+      };
+      load(0);
+      ParallelFor(1, thr_count_, load);
       msg_priority_ = true;
-      break;
+    } break;
     case oTerminate:
       break;
 
@@ -616,7 +750,8 @@ void AppWorker::RouteMessageWithResponse(
     case oGetCompileInfo:
       LOG(logDebug) << "Compiling app code:" << RM(worker_msg->header.metadata)
                     << std::endl;
-      compile_resp = workers_[0]->CompileHandler(worker_msg->header.metadata);
+      compile_resp =
+          workers_[0]->CompileHandler(std::string(worker_msg->header.metadata));
 
       resp_msg_->msg.assign(compile_resp);
       resp_msg_->msg_type = mV8_Worker_Config;
@@ -648,10 +783,6 @@ void AppWorker::RouteMessageWithResponse(
     }
     break;
   case eDCP:
-    payload = flatbuf::payload::GetPayload(
-        (const void *)worker_msg->payload.payload.c_str());
-    val.assign(payload->value()->str());
-
     switch (getDCPOpcode(worker_msg->header.opcode)) {
     case oDelete:
       worker_index = partition_thr_map_[worker_msg->header.partition];
@@ -752,7 +883,8 @@ void AppWorker::RouteMessageWithResponse(
   case eApp_Worker_Setting:
     switch (getAppWorkerSettingOpcode(worker_msg->header.opcode)) {
     case oLogLevel:
-      SystemLog::setLogLevel(LevelFromString(worker_msg->header.metadata));
+      SystemLog::setLogLevel(
+          LevelFromString(std::string(worker_msg->header.metadata)));
       LOG(logInfo) << "Configured log level: " << worker_msg->header.metadata
                    << std::endl;
       msg_priority_ = true;
@@ -760,12 +892,13 @@ void AppWorker::RouteMessageWithResponse(
     case oWorkerThreadCount:
       LOG(logInfo) << "Worker thread count: " << worker_msg->header.metadata
                    << std::endl;
-      thr_count_ = int16_t(std::stoi(worker_msg->header.metadata));
+      thr_count_ =
+          int16_t(std::stoi(std::string(worker_msg->header.metadata)));
       msg_priority_ = true;
       break;
     case oWorkerThreadMap:
       payload = flatbuf::payload::GetPayload(
-          (const void *)worker_msg->payload.payload.c_str());
+          (const void *)worker_msg->payload.payload.data());
       thr_map = payload->thr_map();
       partition_count_ = payload->partitionCount();
       LOG(logInfo) << "Request for worker thread map, size: " << thr_map->size()
@@ -783,7 +916,7 @@ void AppWorker::RouteMessageWithResponse(
       msg_priority_ = true;
       break;
     case oTimerContextSize:
-      timer_context_size = std::stol(worker_msg->header.metadata);
+      timer_context_size = std::stol(std::string(worker_msg->header.metadata));
       LOG(logInfo) << "Setting timer_context_size to " << timer_context_size
                    << std::endl;
       msg_priority_ = true;
@@ -791,7 +924,7 @@ void AppWorker::RouteMessageWithResponse(
 
     case oVbMap: {
       payload = flatbuf::payload::GetPayload(
-          (const void *)worker_msg->payload.payload.c_str());
+          (const void *)worker_msg->payload.payload.data());
       auto vb_map = payload->vb_map();
       std::vector<int64_t> vbuckets;
       for (size_t idx = 0; idx < vb_map->size(); ++idx) {
@@ -812,7 +945,7 @@ void AppWorker::RouteMessageWithResponse(
     } break;
 
     case oWorkerMemQuota: {
-      memory_quota_ = std::stoll(worker_msg->header.metadata);
+      memory_quota_ = std::stoll(std::string(worker_msg->header.metadata));
       msg_priority_ = true;
       break;
     }
@@ -975,6 +1108,9 @@ AppWorker::~AppWorker() {
   for (auto &v8worker : workers_) {
     delete v8worker.second;
   }
+  // Isolates may read from the blob for as long as they live
+  delete snapshot_;
+  delete code_cache_;
 
   uv_loop_close(&feedback_loop_);
   uv_loop_close(&main_loop_);
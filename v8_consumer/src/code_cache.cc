@@ -0,0 +1,110 @@
+// Copyright (c) 2019 Couchbase, Inc.
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//     http://www.apache.org/licenses/LICENSE-2.0
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an "AS IS"
+// BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express
+// or implied. See the License for the specific language governing
+// permissions and limitations under the License.
+
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <unistd.h>
+#include <v8.h>
+
+#include "code_cache.h"
+#include "crc64.h"
+#include "log.h"
+
+CodeCache::CodeCache(std::string path) : path_(std::move(path)) {}
+
+std::string CodeCache::GetKey(const std::string &source) const {
+  auto checksum = crc64_iso.Checksum(
+      reinterpret_cast<const uint8_t *>(source.data()), source.size());
+  std::ostringstream key;
+  key << v8::V8::GetVersion() << "-" << std::hex << checksum << "-"
+      << std::dec << source.size();
+  return key.str();
+}
+
+std::shared_ptr<const std::string>
+CodeCache::Get(const std::string &source) {
+  const auto key = GetKey(source);
+  std::lock_guard<std::mutex> guard(lock_);
+  if (!is_loaded_) {
+    LoadLocked();
+  }
+  return key == key_ ? data_ : nullptr;
+}
+
+void CodeCache::Put(const std::string &source, const uint8_t *data,
+                    int length) {
+  auto key = GetKey(source);
+  auto cached = std::make_shared<const std::string>(
+      reinterpret_cast<const char *>(data), static_cast<std::size_t>(length));
+
+  std::lock_guard<std::mutex> guard(lock_);
+  is_loaded_ = true;
+  if (key == key_) {
+    return;
+  }
+  key_ = std::move(key);
+  data_ = std::move(cached);
+  PersistLocked();
+}
+
+void CodeCache::Invalidate(const std::string &source) {
+  const auto key = GetKey(source);
+  std::lock_guard<std::mutex> guard(lock_);
+  if (key == key_) {
+    key_.clear();
+    data_.reset();
+    std::remove(path_.c_str());
+  }
+}
+
+// The file holds the key on the first line followed by the cached data
+void CodeCache::LoadLocked() {
+  is_loaded_ = true;
+  std::ifstream file(path_, std::ios::binary);
+  if (!file.is_open()) {
+    return;
+  }
+
+  std::string key;
+  if (!std::getline(file, key)) {
+    return;
+  }
+
+  std::ostringstream data;
+  data << file.rdbuf();
+  key_ = std::move(key);
+  data_ = std::make_shared<const std::string>(data.str());
+  LOG(logInfo) << "Loaded code cache of size: " << data_->size() << std::endl;
+}
+
+void CodeCache::PersistLocked() const {
+  // Consumers of the same function share the file, so it's replaced in one go
+  const auto tmp_path = path_ + "." + std::to_string(getpid()) + ".tmp";
+  {
+    std::ofstream file(tmp_path, std::ios::binary | std::ios::trunc);
+    if (!file.is_open()) {
+      LOG(logError) << "Unable to open code cache file for writing"
+                    << std::endl;
+      return;
+    }
+    file << key_ << '\n';
+    file.write(data_->data(), static_cast<std::streamsize>(data_->size()));
+    if (!file.good()) {
+      LOG(logError) << "Unable to write code cache file" << std::endl;
+      return;
+    }
+  }
+
+  if (std::rename(tmp_path.c_str(), path_.c_str()) != 0) {
+    LOG(logError) << "Unable to rename code cache file" << std::endl;
+  }
+}
@@ -0,0 +1,248 @@
+// Copyright (c) 2019 Couchbase, Inc.
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//     http://www.apache.org/licenses/LICENSE-2.0
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an "AS IS"
+// BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express
+// or implied. See the License for the specific language governing
+// permissions and limitations under the License.
+
+#include <limits>
+#include <sstream>
+
+#include "dcp_metadata.h"
+#include "utils.h"
+
+namespace {
+class Scanner {
+public:
+  explicit Scanner(std::string_view json) : json_(json) {}
+
+  bool Consume(char c) {
+    SkipWhitespace();
+    if (pos_ < json_.size() && json_[pos_] == c) {
+      ++pos_;
+      return true;
+    }
+    return false;
+  }
+
+  bool AtEnd() {
+    SkipWhitespace();
+    return pos_ == json_.size();
+  }
+
+  bool ReadString(std::string_view &out, bool &has_escapes) {
+    if (!Consume('"')) {
+      return false;
+    }
+
+    has_escapes = false;
+    const auto start = pos_;
+    for (; pos_ < json_.size(); ++pos_) {
+      if (json_[pos_] == '\\') {
+        has_escapes = true;
+        ++pos_;
+      } else if (json_[pos_] == '"') {
+        out = json_.substr(start, pos_ - start);
+        ++pos_;
+        return true;
+      }
+    }
+    return false;
+  }
+
+  bool ReadUnsigned(uint64_t &out) {
+    SkipWhitespace();
+    const auto start = pos_;
+    uint64_t value = 0;
+    for (; pos_ < json_.size() && IsDigit(json_[pos_]); ++pos_) {
+      const uint64_t digit = json_[pos_] - '0';
+      if (value > (std::numeric_limits<uint64_t>::max() - digit) / 10) {
+        return false;
+      }
+      value = value * 10 + digit;
+    }
+
+    // Fractions and exponents are left to the full parser
+    if (pos_ == start || (pos_ < json_.size() && IsNumberPart(json_[pos_]))) {
+      return false;
+    }
+    out = value;
+    return true;
+  }
+
+  bool SkipScalar() {
+    SkipWhitespace();
+    if (pos_ >= json_.size()) {
+      return false;
+    }
+
+    if (json_[pos_] == '"') {
+      std::string_view ignored;
+      bool has_escapes;
+      return ReadString(ignored, has_escapes);
+    }
+
+    const auto start = pos_;
+    while (pos_ < json_.size() &&
+           (IsNumberPart(json_[pos_]) || IsDigit(json_[pos_]) ||
+            (json_[pos_] >= 'a' && json_[pos_] <= 'z'))) {
+      ++pos_;
+    }
+    return pos_ > start;
+  }
+
+private:
+  static bool IsDigit(char c) { return c >= '0' && c <= '9'; }
+
+  static bool IsNumberPart(char c) {
+    return c == '.' || c == 'e' || c == 'E' || c == '-' || c == '+';
+  }
+
+  void SkipWhitespace() {
+    while (pos_ < json_.size() &&
+           (json_[pos_] == ' ' || json_[pos_] == '\t' || json_[pos_] == '\n' ||
+            json_[pos_] == '\r')) {
+      ++pos_;
+    }
+  }
+
+  std::string_view json_;
+  std::size_t pos_{0};
+};
+
+template <typename T> bool ReadBounded(Scanner &scanner, T &out) {
+  uint64_t value = 0;
+  if (!scanner.ReadUnsigned(value) ||
+      value > static_cast<uint64_t>(std::numeric_limits<T>::max())) {
+    return false;
+  }
+  out = static_cast<T>(value);
+  return true;
+}
+} // namespace
+
+bool ScanDcpMetadata(std::string_view json, DcpMetadata &meta) {
+  Scanner scanner(json);
+  if (!scanner.Consume('{')) {
+    return false;
+  }
+
+  auto has_vb = false, has_seq = false;
+  auto num_fields = 0;
+  auto has_unknown_fields = false;
+  do {
+    std::string_view key;
+    auto key_has_escapes = false;
+    if (!scanner.ReadString(key, key_has_escapes) || key_has_escapes ||
+        !scanner.Consume(':')) {
+      return false;
+    }
+
+    auto is_valid = true;
+    if (key == "cas") {
+      is_valid = scanner.ReadUnsigned(meta.cas);
+    } else if (key == "id") {
+      is_valid = scanner.ReadString(meta.id, meta.id_has_escapes);
+    } else if (key == "expiration") {
+      is_valid = ReadBounded(scanner, meta.expiration);
+    } else if (key == "flags") {
+      is_valid = ReadBounded(scanner, meta.flags);
+    } else if (key == "vb") {
+      is_valid = has_vb = ReadBounded(scanner, meta.vb);
+    } else if (key == "seq") {
+      is_valid = has_seq = scanner.ReadUnsigned(meta.seq);
+    } else {
+      is_valid = scanner.SkipScalar();
+      has_unknown_fields = true;
+    }
+
+    if (!is_valid) {
+      return false;
+    }
+    ++num_fields;
+  } while (scanner.Consume(','));
+
+  if (!scanner.Consume('}') || !scanner.AtEnd() || !has_vb || !has_seq) {
+    return false;
+  }
+
+  meta.is_canonical =
+      num_fields == 6 && !has_unknown_fields && !meta.id_has_escapes;
+  return true;
+}
+
+std::string FormatDcpMetadata(const DcpMetadata &meta) {
+  std::ostringstream os;
+  os << "cas: " << meta.cas << " id: " << meta.id
+     << " expiration: " << meta.expiration << " flags: " << meta.flags
+     << " vb: " << meta.vb << " seq: " << meta.seq;
+  return os.str();
+}
+
+DcpMetaBuilder::DcpMetaBuilder(v8::Isolate *isolate) : isolate_(isolate) {
+  v8::HandleScope handle_scope(isolate_);
+
+  // Same order as the keys of the JSON metadata, so that the enumeration order
+  // of the meta object remains as it was
+  const char *names[kNumFields] = {"cas",   "id", "expiration",
+                                   "flags", "vb", "seq"};
+  auto meta_template = v8::ObjectTemplate::New(isolate_);
+  for (int i = 0; i < kNumFields; ++i) {
+    v8::Local<v8::String> key;
+    if (!TO_LOCAL(v8::String::NewFromUtf8(isolate_, names[i],
+                                          v8::NewStringType::kInternalized),
+                  &key)) {
+      continue;
+    }
+    keys_[i].Reset(isolate_, key);
+    meta_template->Set(key, v8::Undefined(isolate_));
+  }
+  template_.Reset(isolate_, meta_template);
+}
+
+DcpMetaBuilder::~DcpMetaBuilder() {
+  template_.Reset();
+  for (auto &key : keys_) {
+    key.Reset();
+  }
+}
+
+bool DcpMetaBuilder::Build(const v8::Local<v8::Context> &context,
+                           const DcpMetadata &meta,
+                           v8::Local<v8::Value> *out) const {
+  v8::Local<v8::Object> meta_obj;
+  if (!TO_LOCAL(template_.Get(isolate_)->NewInstance(context), &meta_obj)) {
+    return false;
+  }
+
+  v8::Local<v8::String> id;
+  if (!TO_LOCAL(v8::String::NewFromUtf8(isolate_, meta.id.data(),
+                                        v8::NewStringType::kNormal,
+                                        static_cast<int>(meta.id.size())),
+                &id)) {
+    return false;
+  }
+
+  v8::Local<v8::Value> values[kNumFields] = {
+      v8::Number::New(isolate_, static_cast<double>(meta.cas)),
+      id,
+      v8::Integer::NewFromUnsigned(isolate_, meta.expiration),
+      v8::Integer::NewFromUnsigned(isolate_, meta.flags),
+      v8::Integer::New(isolate_, meta.vb),
+      v8::Number::New(isolate_, static_cast<double>(meta.seq))};
+
+  for (int i = 0; i < kNumFields; ++i) {
+    auto result = false;
+    if (!TO(meta_obj->Set(context, keys_[i].Get(isolate_), values[i]),
+            &result)) {
+      return false;
+    }
+  }
+
+  *out = meta_obj;
+  return true;
+}
@@ -0,0 +1,57 @@
+// Copyright (c) 2019 Couchbase, Inc.
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//     http://www.apache.org/licenses/LICENSE-2.0
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an "AS IS"
+// BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express
+// or implied. See the License for the specific language governing
+// permissions and limitations under the License.
+
+#include "message_pool.h"
+#include "v8worker.h"
+
+MessagePool::MessagePool(std::size_t max_msgs, std::size_t max_bytes)
+    : max_msgs_(max_msgs), max_bytes_(max_bytes) {
+  free_msgs_.reserve(max_msgs_);
+}
+
+MessagePool::~MessagePool() = default;
+
+std::unique_ptr<WorkerMessage> MessagePool::Acquire() {
+  {
+    std::lock_guard<std::mutex> guard(lock_);
+    if (!free_msgs_.empty()) {
+      auto msg = std::move(free_msgs_.back());
+      free_msgs_.pop_back();
+      bytes_held_ -= msg->payload.GetSize();
+      ++hits_;
+      return msg;
+    }
+  }
+
+  ++misses_;
+  return std::unique_ptr<WorkerMessage>(new WorkerMessage);
+}
+
+void MessagePool::Release(std::unique_ptr<WorkerMessage> msg) {
+  if (msg == nullptr) {
+    return;
+  }
+
+  msg->header = MessageHeader();
+  const auto size = msg->payload.GetSize();
+  // Oversized buffers aren't worth holding on to, they'd only pin memory
+  if (size > max_bytes_ / max_msgs_) {
+    msg->payload = MessagePayload();
+  }
+
+  const auto held = static_cast<int64_t>(msg->payload.GetSize());
+  std::lock_guard<std::mutex> guard(lock_);
+  if (free_msgs_.size() < max_msgs_ &&
+      bytes_held_ + held <= static_cast<int64_t>(max_bytes_)) {
+    bytes_held_ += held;
+    free_msgs_.emplace_back(std::move(msg));
+  }
+}
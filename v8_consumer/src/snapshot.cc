@@ -0,0 +1,115 @@
+// Copyright (c) 2019 Couchbase, Inc.
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//     http://www.apache.org/licenses/LICENSE-2.0
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an "AS IS"
+// BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express
+// or implied. See the License for the specific language governing
+// permissions and limitations under the License.
+
+#include "snapshot.h"
+#include "bucket.h"
+#include "curl.h"
+#include "js_exception.h"
+#include "log.h"
+#include "query-mgr.h"
+#include "timer.h"
+#include "transpiler.h"
+#include "utils.h"
+#include "v8log.h"
+#include "v8worker.h"
+
+namespace {
+bool RunScript(v8::Isolate *isolate, const v8::Local<v8::Context> &context,
+               const std::string &src) {
+  v8::HandleScope handle_scope(isolate);
+  v8::TryCatch try_catch(isolate);
+
+  v8::Local<v8::Script> script;
+  if (!TO_LOCAL(v8::Script::Compile(context, v8Str(isolate, src)), &script)) {
+    return false;
+  }
+
+  v8::Local<v8::Value> result;
+  if (!TO_LOCAL(script->Run(context), &result)) {
+    LOG(logError) << "Snapshot: Unable to run script: "
+                  << ExceptionString(isolate, context, &try_catch)
+                  << std::endl;
+    return false;
+  }
+  return true;
+}
+} // namespace
+
+// Every native callback reachable from the contexts in the snapshot has to be
+// listed here, see V8Worker::NewGlobalObj and Transpiler::NewGlobalObj
+const intptr_t *StartupSnapshot::GetExternalReferences() {
+  static const intptr_t external_references[] = {
+      reinterpret_cast<intptr_t>(CurlFunction),
+      reinterpret_cast<intptr_t>(Log),
+      reinterpret_cast<intptr_t>(CreateTimer),
+      reinterpret_cast<intptr_t>(Crc64Function),
+      reinterpret_cast<intptr_t>(QueryFunction),
+      reinterpret_cast<intptr_t>(GetMultiFunction),
+      reinterpret_cast<intptr_t>(CustomErrorCtor),
+      reinterpret_cast<intptr_t>(Transpiler::Log),
+      0};
+  return external_references;
+}
+
+StartupSnapshot::StartupSnapshot(
+    const std::string &transpiler_src,
+    const std::vector<std::string> &exception_type_names) {
+  v8::SnapshotCreator creator(GetExternalReferences());
+  auto isolate = creator.GetIsolate();
+  // The creator must not be destroyed before CreateBlob is called, so a
+  // failure only marks the blob to be discarded
+  auto is_ok = true;
+  v8::Locker locker(isolate);
+  {
+    v8::HandleScope handle_scope(isolate);
+    creator.SetDefaultContext(v8::Context::New(isolate));
+
+    auto worker_global =
+        V8Worker::NewGlobalObj(isolate, exception_type_names);
+    auto worker_context = v8::Context::New(isolate, nullptr, worker_global);
+    {
+      v8::Context::Scope context_scope(worker_context);
+      // Same as what DeriveFromError does for a context built from scratch
+      std::string derive_src;
+      for (const auto &type_name : exception_type_names) {
+        derive_src +=
+            type_name + ".prototype = Object.create(Error.prototype);";
+      }
+      is_ok = RunScript(isolate, worker_context, derive_src);
+    }
+
+    auto transpiler_context =
+        v8::Context::New(isolate, nullptr, Transpiler::NewGlobalObj(isolate));
+    if (is_ok) {
+      v8::Context::Scope context_scope(transpiler_context);
+      is_ok = RunScript(isolate, transpiler_context, transpiler_src);
+    }
+
+    // The order must match ContextIndex
+    creator.AddContext(worker_context);
+    creator.AddContext(transpiler_context);
+  }
+
+  // Keeping the compiled code spares the workers from compiling the
+  // transpiler bundle again
+  auto blob =
+      creator.CreateBlob(v8::SnapshotCreator::FunctionCodeHandling::kKeep);
+  if (!is_ok) {
+    delete[] blob.data;
+    return;
+  }
+
+  blob_ = blob;
+  LOG(logInfo) << "Created startup snapshot of size: " << blob_.raw_size
+               << std::endl;
+}
+
+StartupSnapshot::~StartupSnapshot() { delete[] blob_.data; }
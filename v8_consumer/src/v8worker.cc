@@ -9,6 +9,7 @@
 // or implied. See the License for the specific language governing
 // permissions and limitations under the License.
 
+#include <algorithm>
 #include <mutex>
 #include <nlohmann/json.hpp>
 #include <string>
@@ -58,24 +59,40 @@ std::atomic<int64_t> enqueued_timer_msg_counter = {0};
 
 std::atomic<int64_t> timer_callback_missing_counter = {0};
 
-v8::Local<v8::ObjectTemplate> V8Worker::NewGlobalObj() const {
-  v8::EscapableHandleScope handle_scope(isolate_);
-
-  auto global = v8::ObjectTemplate::New(isolate_);
-  global->Set(v8::String::NewFromUtf8(isolate_, "curl"),
-              v8::FunctionTemplate::New(isolate_, CurlFunction));
-  global->Set(v8::String::NewFromUtf8(isolate_, "log"),
-              v8::FunctionTemplate::New(isolate_, Log));
-  global->Set(v8::String::NewFromUtf8(isolate_, "createTimer"),
-              v8::FunctionTemplate::New(isolate_, CreateTimer));
-  global->Set(v8::String::NewFromUtf8(isolate_, "crc64"),
-              v8::FunctionTemplate::New(isolate_, Crc64Function));
-  global->Set(v8::String::NewFromUtf8(isolate_, "N1QL"),
-              v8::FunctionTemplate::New(isolate_, QueryFunction));
-
-  for (const auto &type_name : exception_type_names_) {
-    global->Set(v8::String::NewFromUtf8(isolate_, type_name.c_str()),
-                v8::FunctionTemplate::New(isolate_, CustomErrorCtor));
+std::atomic<int64_t> script_compile_time_us = {0};
+std::atomic<int64_t> code_cache_hit = {0};
+std::atomic<int64_t> code_cache_miss = {0};
+std::atomic<int64_t> code_cache_rejected = {0};
+
+std::atomic<int64_t> init_isolate_time_us = {0};
+std::atomic<int64_t> init_context_time_us = {0};
+std::atomic<int64_t> init_lcb_connect_time_us = {0};
+std::atomic<int64_t> load_failure_count = {0};
+
+// Callbacks installed here must be listed in
+// StartupSnapshot::GetExternalReferences
+v8::Local<v8::ObjectTemplate>
+V8Worker::NewGlobalObj(v8::Isolate *isolate,
+                       const std::vector<std::string> &exception_type_names) {
+  v8::EscapableHandleScope handle_scope(isolate);
+
+  auto global = v8::ObjectTemplate::New(isolate);
+  global->Set(v8::String::NewFromUtf8(isolate, "curl"),
+              v8::FunctionTemplate::New(isolate, CurlFunction));
+  global->Set(v8::String::NewFromUtf8(isolate, "log"),
+              v8::FunctionTemplate::New(isolate, Log));
+  global->Set(v8::String::NewFromUtf8(isolate, "createTimer"),
+              v8::FunctionTemplate::New(isolate, CreateTimer));
+  global->Set(v8::String::NewFromUtf8(isolate, "crc64"),
+              v8::FunctionTemplate::New(isolate, Crc64Function));
+  global->Set(v8::String::NewFromUtf8(isolate, "N1QL"),
+              v8::FunctionTemplate::New(isolate, QueryFunction));
+  global->Set(v8::String::NewFromUtf8(isolate, "getMulti"),
+              v8::FunctionTemplate::New(isolate, GetMultiFunction));
+
+  for (const auto &type_name : exception_type_names) {
+    global->Set(v8::String::NewFromUtf8(isolate, type_name.c_str()),
+                v8::FunctionTemplate::New(isolate, CustomErrorCtor));
   }
   return handle_scope.Escape(global);
 }
@@ -108,6 +125,20 @@ void V8Worker::InstallBucketBindings(
   }
 }
 
+void V8Worker::FlushBucketWrites() {
+  for (auto &binding : bucket_bindings_) {
+    binding.FlushPendingWrites();
+  }
+}
+
+void V8Worker::FlushBucketWrites(const Bucket *reader) {
+  for (auto &binding : bucket_bindings_) {
+    if (binding.MustFlushFor(reader)) {
+      binding.FlushPendingWrites();
+    }
+  }
+}
+
 void V8Worker::InitializeIsolateData(const server_settings_t *server_settings,
                                      const handler_config_t *h_config,
                                      const std::string &source_bucket) {
@@ -121,9 +152,19 @@ void V8Worker::InitializeIsolateData(const server_settings_t *server_settings,
   data_.comm = new Communicator(server_settings->host_addr,
                                 server_settings->eventing_port, key.first,
                                 key.second, false, app_name_, isolate_);
-  data_.transpiler =
-      new Transpiler(isolate_, GetTranspilerSrc(), h_config->handler_headers,
-                     h_config->handler_footers, source_bucket);
+  v8::Local<v8::Context> transpiler_context;
+  if (is_context_from_snapshot_ &&
+      TO_LOCAL(v8::Context::FromSnapshot(isolate_,
+                                         StartupSnapshot::kTranspilerContext),
+               &transpiler_context)) {
+    data_.transpiler = new Transpiler(
+        isolate_, transpiler_context, GetTranspilerSrc(),
+        h_config->handler_headers, h_config->handler_footers, source_bucket);
+  } else {
+    data_.transpiler =
+        new Transpiler(isolate_, GetTranspilerSrc(), h_config->handler_headers,
+                       h_config->handler_footers, source_bucket);
+  }
   data_.timer = new Timer(isolate_, context);
   // TODO : Need to make HEAD call to all the bindings to establish TCP
   // Connections
@@ -133,9 +174,10 @@ void V8Worker::InitializeIsolateData(const server_settings_t *server_settings,
   data_.custom_error = new CustomError(isolate_, context);
   data_.curl_codex = new CurlCodex;
   data_.code_insight = new CodeInsight(isolate_);
-  data_.query_mgr =
-      new Query::Manager(isolate_, cb_source_bucket_,
-                         static_cast<std::size_t>(h_config->lcb_inst_capacity));
+  data_.query_mgr = new Query::Manager(
+      isolate_, cb_source_bucket_,
+      static_cast<std::size_t>(h_config->lcb_inst_capacity),
+      static_cast<std::size_t>(h_config->n1ql_min_connections));
   data_.query_iterable = new Query::Iterable(isolate_, context);
   data_.query_iterable_impl = new Query::IterableImpl(isolate_, context);
   data_.query_iterable_result = new Query::IterableResult(isolate_, context);
@@ -155,8 +197,15 @@ void V8Worker::InitializeIsolateData(const server_settings_t *server_settings,
   data_.n1ql_consistency =
       Query::Helper::GetConsistency(h_config->n1ql_consistency);
   data_.n1ql_prepare_all = h_config->n1ql_prepare_all;
+  data_.n1ql_prefetch_rows = h_config->n1ql_prefetch_rows;
+  data_.n1ql_prefetch_bytes = h_config->n1ql_prefetch_bytes;
+  data_.pipeline_bucket_writes = h_config->pipeline_bucket_writes;
   data_.lang_compat = new LanguageCompatibility(h_config->lang_compat);
   data_.lcb_retry_count = h_config->lcb_retry_count;
+  data_.bucket_cache_size = h_config->bucket_cache_size;
+  data_.bucket_cache_age = h_config->bucket_cache_age;
+  data_.bucket_cache_parsed_docs = h_config->bucket_cache_parsed_docs;
+  data_.bucket_op_timeout = h_config->bucket_op_timeout;
 }
 
 void V8Worker::InitializeCurlBindingValues(
@@ -166,6 +215,24 @@ void V8Worker::InitializeCurlBindingValues(
   }
 }
 
+static int64_t ElapsedMicros(const Time::time_point &start_time) {
+  return std::chrono::duration_cast<std::chrono::microseconds>(Time::now() -
+                                                               start_time)
+      .count();
+}
+
+// Setting CB_EVENTING_WORKER_QUEUE=ring in the environment switches the worker
+// queue over to the lock-free RingQueue, BlockingDeque remains the default
+static MessageQueue<std::unique_ptr<WorkerMessage>> *NewWorkerQueue() {
+  const char *queue_type = std::getenv("CB_EVENTING_WORKER_QUEUE");
+  if (queue_type != nullptr && std::string(queue_type) == "ring") {
+    LOG(logInfo) << "Using ring queue for worker messages" << std::endl;
+    return new RingQueue<std::unique_ptr<WorkerMessage>>(
+        WORKER_QUEUE_CAPACITY, WORKER_QUEUE_PRIORITY_CAPACITY);
+  }
+  return new BlockingDeque<std::unique_ptr<WorkerMessage>>();
+}
+
 V8Worker::V8Worker(v8::Platform *platform, handler_config_t *h_config,
                    server_settings_t *server_settings,
                    const std::string &function_name,
@@ -173,14 +240,14 @@ V8Worker::V8Worker(v8::Platform *platform, handler_config_t *h_config,
                    const std::string &function_instance_id,
                    const std::string &user_prefix, Histogram *latency_stats,
                    Histogram *curl_latency_stats,
-                   const std::string &ns_server_port)
+                   const std::string &ns_server_port,
+                   StartupSnapshot *snapshot, CodeCache *code_cache)
     : app_name_(h_config->app_name), settings_(server_settings),
       latency_stats_(latency_stats), curl_latency_stats_(curl_latency_stats),
       platform_(platform), function_name_(function_name),
       function_id_(function_id), user_prefix_(user_prefix),
-      ns_server_port_(ns_server_port),
-      exception_type_names_(
-          {"KVError", "N1QLError", "EventingError", "CurlError"}) {
+      ns_server_port_(ns_server_port), code_cache_(code_cache),
+      exception_type_names_(GetExceptionTypeNames()) {
   auto config = ParseDeployment(h_config->dep_cfg.c_str());
   cb_source_bucket_.assign(config->source_bucket);
   std::ostringstream oss;
@@ -197,21 +264,39 @@ V8Worker::V8Worker(v8::Platform *platform, handler_config_t *h_config,
   v8::Isolate::CreateParams create_params;
   create_params.array_buffer_allocator =
       v8::ArrayBuffer::Allocator::NewDefaultAllocator();
+  if (snapshot != nullptr && snapshot->IsValid()) {
+    create_params.snapshot_blob = snapshot->GetBlob();
+    create_params.external_references =
+        StartupSnapshot::GetExternalReferences();
+  }
 
+  auto start_time = Time::now();
   isolate_ = v8::Isolate::New(create_params);
   isolate_->SetData(IsolateData::index, &data_);
   isolate_->SetCaptureStackTraceForUncaughtExceptions(true);
+  init_stats_.isolate_time_us = ElapsedMicros(start_time);
+  init_isolate_time_us += init_stats_.isolate_time_us;
 
   v8::Locker locker(isolate_);
   v8::Isolate::Scope isolate_scope(isolate_);
   v8::HandleScope handle_scope(isolate_);
 
-  auto global = NewGlobalObj();
-  auto context = v8::Context::New(isolate_, nullptr, global);
+  start_time = Time::now();
+  v8::Local<v8::Context> context;
+  if (create_params.snapshot_blob != nullptr &&
+      TO_LOCAL(
+          v8::Context::FromSnapshot(isolate_, StartupSnapshot::kWorkerContext),
+          &context)) {
+    is_context_from_snapshot_ = true;
+  } else {
+    auto global = NewGlobalObj(isolate_, exception_type_names_);
+    context = v8::Context::New(isolate_, nullptr, global);
+  }
   context_.Reset(isolate_, context);
 
   v8::Context::Scope context_scope(context);
   InitializeIsolateData(server_settings, h_config, config->source_bucket);
+  meta_builder_ = new DcpMetaBuilder(isolate_);
   InstallCurlBindings(config->curl_bindings);
   InitializeCurlBindingValues(config->curl_bindings);
 
@@ -219,12 +304,12 @@ V8Worker::V8Worker(v8::Platform *platform, handler_config_t *h_config,
   if (!h_config->skip_lcb_bootstrap) {
     InstallBucketBindings(config->component_configs);
   }
+  init_stats_.context_time_us = ElapsedMicros(start_time);
+  init_context_time_us += init_stats_.context_time_us;
 
   execute_start_time_ = Time::now();
   max_task_duration_ = SECS_TO_NS * h_config->execution_timeout;
 
-  timer_context_size = h_config->timer_context_size;
-
   LOG(logInfo) << "Initialised V8Worker handle, app_name: "
                << h_config->app_name
                << " debugger port: " << RS(settings_->debugger_port)
@@ -239,6 +324,9 @@ V8Worker::V8Worker(v8::Platform *platform, handler_config_t *h_config,
                << " language compatibility: " << h_config->lang_compat
                << " version: " << EventingVer()
                << " n1ql_prepare_all: " << h_config->n1ql_prepare_all
+               << " pipeline_bucket_writes: "
+               << h_config->pipeline_bucket_writes
+               << " bucket_op_timeout: " << h_config->bucket_op_timeout
                << std::endl;
 
   src_path_ = settings_->eventing_dir + "/" + app_name_ + ".t.js";
@@ -246,11 +334,16 @@ V8Worker::V8Worker(v8::Platform *platform, handler_config_t *h_config,
   if (h_config->using_timer) {
     std::vector<int64_t> partitions;
     auto prefix = user_prefix + "::" + function_id;
+    start_time = Time::now();
     timer_store_ = new timer::TimerStore(isolate_, prefix, partitions,
                                          config->metadata_bucket);
+    init_stats_.lcb_connect_time_us = ElapsedMicros(start_time);
+    init_lcb_connect_time_us += init_stats_.lcb_connect_time_us;
   }
   delete config;
-  this->worker_queue_ = new BlockingDeque<std::unique_ptr<WorkerMessage>>();
+  this->worker_queue_ = NewWorkerQueue();
+  this->message_pool_ =
+      new MessagePool(MESSAGE_POOL_MAX_MSGS, MESSAGE_POOL_MAX_BYTES);
 
   std::thread r_thr(&V8Worker::RouteMessage, this);
   processing_thr_ = std::move(r_thr);
@@ -264,6 +357,8 @@ V8Worker::~V8Worker() {
   FreeCurlBindings();
 
   auto data = UnwrapData(isolate_);
+  // Stops the pool warmer first as it uses comm and utils
+  delete data->query_mgr;
   delete data->custom_error;
   delete data->comm;
   delete data->transpiler;
@@ -274,18 +369,21 @@ V8Worker::~V8Worker() {
   delete data->req_builder;
   delete data->resp_builder;
   delete data->curl_codex;
-  delete data->query_mgr;
   delete data->query_iterable;
   delete data->query_iterable_impl;
   delete data->query_iterable_result;
   delete data->query_helper;
   delete data->lang_compat;
+  delete meta_builder_;
 
   context_.Reset();
   on_update_.Reset();
   on_delete_.Reset();
+  on_update_batch_.Reset();
+  on_delete_batch_.Reset();
   delete settings_;
   delete worker_queue_;
+  delete message_pool_;
   delete timer_store_;
 }
 
@@ -344,8 +442,10 @@ bool V8Worker::DebugExecute(const char *func_name, v8::Local<v8::Value> *args,
                         IsTerminatingRetriable, IsExecutionTerminating,
                         isolate_);
   DebugExecuteGuard guard(isolate_);
-  if (!TO_LOCAL(func->Call(context, v8::Null(isolate_), args_len, args),
-                &result)) {
+  auto is_called = TO_LOCAL(
+      func->Call(context, v8::Null(isolate_), args_len, args), &result);
+  FlushBucketWrites();
+  if (!is_called) {
     return false;
   }
 
@@ -356,8 +456,7 @@ bool V8Worker::DebugExecute(const char *func_name, v8::Local<v8::Value> *args,
   return true;
 }
 
-int V8Worker::V8WorkerLoad(std::string script_to_execute) {
-  LOG(logInfo) << "Eventing dir: " << RS(settings_->eventing_dir) << std::endl;
+std::string V8Worker::TranspileHandler(const std::string &handler) {
   v8::Locker locker(isolate_);
   v8::Isolate::Scope isolate_scope(isolate_);
   v8::HandleScope handle_scope(isolate_);
@@ -366,12 +465,25 @@ int V8Worker::V8WorkerLoad(std::string script_to_execute) {
   auto transpiler = UnwrapData(isolate_)->transpiler;
   v8::Context::Scope context_scope(context);
 
-  for (const auto &type_name : exception_type_names_) {
-    DeriveFromError(isolate_, context, type_name);
+  return transpiler->AddHeadersAndFooters(handler) + '\n';
+}
+
+int V8Worker::LoadTranspiledHandler(std::string script_to_execute) {
+  LOG(logInfo) << "Eventing dir: " << RS(settings_->eventing_dir) << std::endl;
+  v8::Locker locker(isolate_);
+  v8::Isolate::Scope isolate_scope(isolate_);
+  v8::HandleScope handle_scope(isolate_);
+
+  auto context = context_.Get(isolate_);
+  v8::Context::Scope context_scope(context);
+
+  // Error classes in a context from the snapshot are derived already
+  if (!is_context_from_snapshot_) {
+    for (const auto &type_name : exception_type_names_) {
+      DeriveFromError(isolate_, context, type_name);
+    }
   }
 
-  auto final_code = transpiler->AddHeadersAndFooters(script_to_execute);
-  script_to_execute = final_code + '\n';
   LOG(logTrace) << "script to execute: " << RM(script_to_execute) << std::endl;
   script_to_execute_ = script_to_execute;
 
@@ -395,7 +507,23 @@ int V8Worker::V8WorkerLoad(std::string script_to_execute) {
     return kToLocalFailed;
   }
 
-  if (!on_update_def->IsFunction() && !on_delete_def->IsFunction()) {
+  // Batch handlers are optional, when defined they take precedence over
+  // OnUpdate/OnDelete for DCP events
+  v8::Local<v8::Value> on_update_batch_def;
+  if (!TO_LOCAL(global->Get(context, v8Str(isolate_, "OnUpdateBatch")),
+                &on_update_batch_def)) {
+    return kToLocalFailed;
+  }
+
+  v8::Local<v8::Value> on_delete_batch_def;
+  if (!TO_LOCAL(global->Get(context, v8Str(isolate_, "OnDeleteBatch")),
+                &on_delete_batch_def)) {
+    return kToLocalFailed;
+  }
+
+  if (!on_update_def->IsFunction() && !on_delete_def->IsFunction() &&
+      !on_update_batch_def->IsFunction() &&
+      !on_delete_batch_def->IsFunction()) {
     return kNoHandlersDefined;
   }
 
@@ -409,6 +537,17 @@ int V8Worker::V8WorkerLoad(std::string script_to_execute) {
     on_delete_.Reset(isolate_, on_delete_fun);
   }
 
+  if (on_update_batch_def->IsFunction()) {
+    auto on_update_batch_fun = on_update_batch_def.As<v8::Function>();
+    on_update_batch_.Reset(isolate_, on_update_batch_fun);
+  }
+
+  if (on_delete_batch_def->IsFunction()) {
+    auto on_delete_batch_fun = on_delete_batch_def.As<v8::Function>();
+    on_delete_batch_.Reset(isolate_, on_delete_batch_fun);
+  }
+
+  const auto connect_start_time = Time::now();
   for (auto &binding : bucket_bindings_) {
     auto error = binding.InstallBinding(isolate_, context);
     if (error != nullptr) {
@@ -416,6 +555,10 @@ int V8Worker::V8WorkerLoad(std::string script_to_execute) {
                     << std::endl;
     }
   }
+  const auto connect_time = ElapsedMicros(connect_start_time);
+  init_stats_.lcb_connect_time_us += connect_time;
+  init_lcb_connect_time_us += connect_time;
+  data_.query_mgr->WarmConnections();
 
   // Spawning terminator thread to monitor the wall clock time for execution
   // of javascript code isn't going beyond max_task_duration
@@ -424,38 +567,46 @@ int V8Worker::V8WorkerLoad(std::string script_to_execute) {
 }
 
 void V8Worker::RouteMessage() {
-  std::string val, context, callback;
+  WorkerMessageBatch batch;
+  batch.reserve(MAX_DCP_BATCH_SIZE);
+
   while (!thread_exit_cond_.load()) {
     std::unique_ptr<WorkerMessage> msg;
     if (!worker_queue_->PopFront(msg)) {
       continue;
     }
 
+    // Drain the DCP events which are already queued up behind this one, so
+    // that they can all be dispatched under a single isolate lock
+    while (getEvent(msg->header.event) == eDCP) {
+      batch.emplace_back(std::move(msg));
+      if (batch.size() >= MAX_DCP_BATCH_SIZE ||
+          !worker_queue_->TryPopFront(msg)) {
+        break;
+      }
+    }
+
+    if (!batch.empty()) {
+      HandleDCPBatch(batch);
+      for (auto &dcp_msg : batch) {
+        ++messages_processed_counter;
+        message_pool_->Release(std::move(dcp_msg));
+      }
+      batch.clear();
+    }
+
+    // Non-DCP message that ended the batch, if any
+    if (msg == nullptr) {
+      continue;
+    }
+
     LOG(logTrace) << " event: " << static_cast<int16_t>(msg->header.event)
                   << " opcode: " << static_cast<int16_t>(msg->header.opcode)
-                  << " metadata: " << RU(msg->header.metadata)
+                  << " metadata: " << RU(msg->header.GetMetadataString())
                   << " partition: " << msg->header.partition << std::endl;
 
     auto evt = getEvent(msg->header.event);
     switch (evt) {
-    case eDCP:
-      switch (getDCPOpcode(msg->header.opcode)) {
-      case oDelete:
-        HandleDeleteEvent(msg);
-        break;
-
-      case oMutation:
-        HandleMutationEvent(msg);
-        break;
-
-      default:
-        LOG(logError) << "Received invalid DCP opcode" << std::endl;
-        break;
-      }
-      processed_events_size += msg->payload.GetSize();
-      num_processed_events++;
-      break;
-
     case eInternal:
       switch (msg->header.opcode) {
       case oScanTimer: {
@@ -505,6 +656,125 @@ void V8Worker::RouteMessage() {
     }
 
     ++messages_processed_counter;
+    message_pool_->Release(std::move(msg));
+  }
+}
+
+void V8Worker::HandleDCPBatch(const WorkerMessageBatch &batch) {
+  v8::Locker locker(isolate_);
+  v8::Isolate::Scope isolate_scope(isolate_);
+  v8::HandleScope handle_scope(isolate_);
+
+  auto context = context_.Get(isolate_);
+  v8::Context::Scope context_scope(context);
+
+  for (auto it = batch.begin(); it != batch.end();) {
+    const auto &msg = *it;
+    LOG(logTrace) << " event: " << static_cast<int16_t>(msg->header.event)
+                  << " opcode: " << static_cast<int16_t>(msg->header.opcode)
+                  << " metadata: " << RU(msg->header.GetMetadataString())
+                  << " partition: " << msg->header.partition << std::endl;
+
+    const auto opcode = getDCPOpcode(msg->header.opcode);
+    if (IsBatchHandlerDefined(opcode)) {
+      // Consecutive events of the same kind from one partition go to the
+      // batch handler in a single call
+      auto run_end = it + 1;
+      while (run_end != batch.end() &&
+             (*run_end)->header.opcode == msg->header.opcode &&
+             (*run_end)->header.partition == msg->header.partition) {
+        ++run_end;
+      }
+      HandleEventRun(it, run_end, opcode);
+      for (; it != run_end; ++it) {
+        processed_events_size += (*it)->payload.GetLength();
+        num_processed_events++;
+      }
+      continue;
+    }
+
+    switch (opcode) {
+    case oDelete:
+      HandleDeleteEvent(msg);
+      break;
+
+    case oMutation:
+      HandleMutationEvent(msg);
+      break;
+
+    default:
+      LOG(logError) << "Received invalid DCP opcode" << std::endl;
+      break;
+    }
+    processed_events_size += msg->payload.GetLength();
+    num_processed_events++;
+    ++it;
+  }
+}
+
+// Under the debugger, events go one at a time through SendUpdate/SendDelete
+bool V8Worker::IsBatchHandlerDefined(dcp_opcode opcode) const {
+  if (debugger_started_) {
+    return false;
+  }
+
+  switch (opcode) {
+  case oMutation:
+    return !on_update_batch_.IsEmpty();
+  case oDelete:
+    return !on_delete_batch_.IsEmpty();
+  default:
+    return false;
+  }
+}
+
+void V8Worker::HandleEventRun(WorkerMessageBatch::const_iterator begin,
+                              WorkerMessageBatch::const_iterator end,
+                              dcp_opcode opcode) {
+  std::vector<const WorkerMessage *> events;
+  std::vector<std::pair<int, uint64_t>> seq_nums;
+  events.reserve(end - begin);
+  seq_nums.reserve(end - begin);
+
+  for (auto it = begin; it != end; ++it) {
+    if (opcode == oMutation) {
+      ++dcp_mutation_msg_counter;
+    } else {
+      ++dcp_delete_msg_counter;
+    }
+
+    auto [vb, seq_num, is_valid] = GetVbAndSeqNum(*it);
+    if (!is_valid) {
+      if (opcode == oMutation) {
+        ++dcp_mutation_parse_failure;
+      } else {
+        ++dcp_delete_parse_failure;
+      }
+      continue;
+    }
+
+    std::lock_guard<std::mutex> guard(bucketops_lock_);
+    if (IsFilteredEventLocked(vb, seq_num)) {
+      continue;
+    }
+    events.emplace_back(it->get());
+    seq_nums.emplace_back(vb, seq_num);
+  }
+
+  if (events.empty()) {
+    return;
+  }
+
+  if (opcode == oMutation) {
+    SendUpdateBatch(events);
+  } else {
+    SendDeleteBatch(events);
+  }
+
+  // Checkpoints move forward only once the whole batch has been handled
+  std::lock_guard<std::mutex> guard(bucketops_lock_);
+  for (const auto &[vb, seq_num] : seq_nums) {
+    UpdateSeqNumLocked(vb, seq_num);
   }
 }
 
@@ -532,7 +802,7 @@ void V8Worker::HandleDeleteEvent(const std::unique_ptr<WorkerMessage> &msg) {
     UpdateSeqNumLocked(vb, seq_num);
   }
 
-  SendDelete(msg->header.metadata);
+  SendDelete(msg->header);
 }
 
 void V8Worker::HandleMutationEvent(const std::unique_ptr<WorkerMessage> &msg) {
@@ -553,18 +823,45 @@ void V8Worker::HandleMutationEvent(const std::unique_ptr<WorkerMessage> &msg) {
   }
 
   const auto doc = flatbuf::payload::GetPayload(
-      static_cast<const void *>(msg->payload.payload.c_str()));
-  SendUpdate(doc->value()->str(), msg->header.metadata);
+      static_cast<const void *>(msg->payload.payload.data()));
+  const auto value = doc->value();
+  SendUpdate(std::string_view(value->c_str(), value->size()), msg->header);
 }
 
 std::tuple<int, uint64_t, bool>
 V8Worker::GetVbAndSeqNum(const std::unique_ptr<WorkerMessage> &msg) const {
+  if (msg->header.has_typed_meta) {
+    return {msg->header.dcp_meta.vb, msg->header.dcp_meta.seq, true};
+  }
+
+  DcpMetadata meta;
+  if (ScanDcpMetadata(msg->header.metadata, meta)) {
+    return {meta.vb, meta.seq, true};
+  }
+
   auto vb = 0;
   uint64_t seq_num = 0;
   auto result = ParseMetadata(msg->header.metadata, vb, seq_num);
   return {vb, seq_num, result == kSuccess};
 }
 
+// Builds the meta argument of the handlers without going through JSON.parse
+// whenever the metadata is typed or has the usual shape
+bool V8Worker::NewMetaObject(const v8::Local<v8::Context> &context,
+                             const MessageHeader &header,
+                             v8::Local<v8::Value> *out) const {
+  if (header.has_typed_meta) {
+    return meta_builder_->Build(context, header.dcp_meta, out);
+  }
+
+  DcpMetadata dcp_meta;
+  if (ScanDcpMetadata(header.metadata, dcp_meta) && dcp_meta.is_canonical) {
+    return meta_builder_->Build(context, dcp_meta, out);
+  }
+  return TO_LOCAL(v8::JSON::Parse(context, v8Str(isolate_, header.metadata)),
+                  out);
+}
+
 bool V8Worker::IsFilteredEventLocked(const int vb, const uint64_t seq_num) {
   const auto filter_seq_no = GetVbFilter(vb);
   if (filter_seq_no > 0 && seq_num <= filter_seq_no) {
@@ -586,8 +883,25 @@ bool V8Worker::ExecuteScript(const v8::Local<v8::String> &script) {
   auto script_name = v8Str(isolate_, app_name_ + ".js");
   v8::ScriptOrigin origin(script_name);
 
+  const auto start_time = Time::now();
+  std::shared_ptr<const std::string> cached;
+  v8::ScriptCompiler::CachedData *cached_data = nullptr;
+  if (code_cache_ != nullptr) {
+    cached = code_cache_->Get(script_to_execute_);
+  }
+  if (cached != nullptr) {
+    // Doesn't take ownership of the buffer, cached keeps it alive
+    cached_data = new v8::ScriptCompiler::CachedData(
+        reinterpret_cast<const uint8_t *>(cached->data()),
+        static_cast<int>(cached->size()));
+  }
+
+  v8::ScriptCompiler::Source source(script, origin, cached_data);
+  auto options = cached_data != nullptr
+                     ? v8::ScriptCompiler::kConsumeCodeCache
+                     : v8::ScriptCompiler::kNoCompileOptions;
   v8::Local<v8::Script> compiled_script;
-  if (!v8::Script::Compile(context, script, &origin)
+  if (!v8::ScriptCompiler::Compile(context, &source, options)
            .ToLocal(&compiled_script)) {
     assert(try_catch.HasCaught());
     LOG(logError) << "Exception logged:"
@@ -597,6 +911,25 @@ bool V8Worker::ExecuteScript(const v8::Local<v8::String> &script) {
     return false;
   }
 
+  const auto compile_time =
+      std::chrono::duration_cast<std::chrono::microseconds>(Time::now() -
+                                                            start_time);
+  script_compile_time_us += compile_time.count();
+  init_stats_.compile_time_us = compile_time.count();
+  LOG(logInfo) << "Compiled handler in " << compile_time.count() << "us"
+               << std::endl;
+
+  auto should_produce_cache = code_cache_ != nullptr;
+  if (cached_data == nullptr) {
+    ++code_cache_miss;
+  } else if (source.GetCachedData()->rejected) {
+    ++code_cache_rejected;
+    code_cache_->Invalidate(script_to_execute_);
+  } else {
+    ++code_cache_hit;
+    should_produce_cache = false;
+  }
+
   v8::Local<v8::Value> result;
   if (!compiled_script->Run(context).ToLocal(&result)) {
     assert(try_catch.HasCaught());
@@ -607,6 +940,17 @@ bool V8Worker::ExecuteScript(const v8::Local<v8::String> &script) {
     return false;
   }
 
+  // Produced after running the script, so that the functions compiled lazily
+  // while doing so are part of the cache
+  if (should_produce_cache) {
+    std::unique_ptr<v8::ScriptCompiler::CachedData> code_cache(
+        v8::ScriptCompiler::CreateCodeCache(
+            compiled_script->GetUnboundScript()));
+    if (code_cache != nullptr) {
+      code_cache_->Put(script_to_execute_, code_cache->data,
+                       code_cache->length);
+    }
+  }
   return true;
 }
 
@@ -634,28 +978,32 @@ void V8Worker::UpdateCurlLatencyHistogram(const Time::time_point &start) {
   curl_latency_stats_->Add(ns.count() / 1000);
 }
 
-int V8Worker::SendUpdate(const std::string &value, const std::string &meta) {
+// The isolate must be locked and context_ entered by the caller, see
+// HandleDCPBatch
+int V8Worker::SendUpdate(std::string_view value,
+                         const MessageHeader &header) {
   const auto start_time = Time::now();
 
-  v8::Locker locker(isolate_);
-  v8::Isolate::Scope isolate_scope(isolate_);
   v8::HandleScope handle_scope(isolate_);
+  auto context = isolate_->GetCurrentContext();
 
-  auto context = context_.Get(isolate_);
-  v8::Context::Scope context_scope(context);
-
-  LOG(logTrace) << "value: " << RU(value) << " meta: " << RU(meta) << std::endl;
+  LOG(logTrace) << "value: " << RU(std::string(value))
+                << " meta: " << RU(header.GetMetadataString()) << std::endl;
   v8::TryCatch try_catch(isolate_);
 
   v8::Local<v8::Value> args[2];
   if (!TO_LOCAL(v8::JSON::Parse(context, v8Str(isolate_, value)), &args[0])) {
     return kToLocalFailed;
   }
-  if (!TO_LOCAL(v8::JSON::Parse(context, v8Str(isolate_, meta)), &args[1])) {
+  if (!NewMetaObject(context, header, &args[1])) {
     return kToLocalFailed;
   }
 
-  if (on_update_.IsEmpty()) {
+  // The debugger runs one event at a time, so a batch-only handler gets
+  // single-element arrays
+  const auto is_batch_only =
+      on_update_.IsEmpty() && !on_update_batch_.IsEmpty();
+  if (on_update_.IsEmpty() && !(debugger_started_ && is_batch_only)) {
     UpdateHistogram(start_time);
     return kOnUpdateCallFail;
   }
@@ -672,6 +1020,13 @@ int V8Worker::SendUpdate(const std::string &value, const std::string &meta) {
     }
 
     agent_->PauseOnNextJavascriptStatement("Break on start");
+    if (is_batch_only) {
+      if (!WrapInArrays(context, args, 2)) {
+        return kToLocalFailed;
+      }
+      return DebugExecute("OnUpdateBatch", args, 2) ? kSuccess
+                                                     : kOnUpdateCallFail;
+    }
     return DebugExecute("OnUpdate", args, 2) ? kSuccess : kOnUpdateCallFail;
   }
 
@@ -686,6 +1041,7 @@ int V8Worker::SendUpdate(const std::string &value, const std::string &meta) {
   UnwrapData(isolate_)->is_executing_ = false;
   auto query_mgr = UnwrapData(isolate_)->query_mgr;
   query_mgr->ClearQueries();
+  FlushBucketWrites();
 
   if (try_catch.HasCaught()) {
     UpdateHistogram(start_time);
@@ -701,25 +1057,25 @@ int V8Worker::SendUpdate(const std::string &value, const std::string &meta) {
   return kSuccess;
 }
 
-int V8Worker::SendDelete(const std::string &meta) {
+// The isolate must be locked and context_ entered by the caller, see
+// HandleDCPBatch
+int V8Worker::SendDelete(const MessageHeader &header) {
   const auto start_time = Time::now();
 
-  v8::Locker locker(isolate_);
-  v8::Isolate::Scope isolate_scope(isolate_);
   v8::HandleScope handle_scope(isolate_);
+  auto context = isolate_->GetCurrentContext();
 
-  auto context = context_.Get(isolate_);
-  v8::Context::Scope context_scope(context);
-
-  LOG(logTrace) << " meta: " << RU(meta) << std::endl;
+  LOG(logTrace) << " meta: " << RU(header.GetMetadataString()) << std::endl;
   v8::TryCatch try_catch(isolate_);
 
   v8::Local<v8::Value> args[1];
-  if (!TO_LOCAL(v8::JSON::Parse(context, v8Str(isolate_, meta)), &args[0])) {
+  if (!NewMetaObject(context, header, &args[0])) {
     return kToLocalFailed;
   }
 
-  if (on_delete_.IsEmpty()) {
+  const auto is_batch_only =
+      on_delete_.IsEmpty() && !on_delete_batch_.IsEmpty();
+  if (on_delete_.IsEmpty() && !(debugger_started_ && is_batch_only)) {
     UpdateHistogram(start_time);
     return kOnDeleteCallFail;
   }
@@ -732,6 +1088,13 @@ int V8Worker::SendDelete(const std::string &meta) {
     }
 
     agent_->PauseOnNextJavascriptStatement("Break on start");
+    if (is_batch_only) {
+      if (!WrapInArrays(context, args, 1)) {
+        return kToLocalFailed;
+      }
+      return DebugExecute("OnDeleteBatch", args, 1) ? kSuccess
+                                                     : kOnDeleteCallFail;
+    }
     return DebugExecute("OnDelete", args, 1) ? kSuccess : kOnDeleteCallFail;
   }
 
@@ -746,6 +1109,7 @@ int V8Worker::SendDelete(const std::string &meta) {
   UnwrapData(isolate_)->is_executing_ = false;
   auto query_mgr = UnwrapData(isolate_)->query_mgr;
   query_mgr->ClearQueries();
+  FlushBucketWrites();
 
   if (try_catch.HasCaught()) {
     LOG(logDebug) << "OnDelete Exception: "
@@ -761,6 +1125,149 @@ int V8Worker::SendDelete(const std::string &meta) {
   return kSuccess;
 }
 
+// The isolate must be locked and context_ entered by the caller, see
+// HandleDCPBatch
+int V8Worker::SendUpdateBatch(
+    const std::vector<const WorkerMessage *> &events) {
+  const auto start_time = Time::now();
+
+  v8::HandleScope handle_scope(isolate_);
+  auto context = isolate_->GetCurrentContext();
+  v8::TryCatch try_catch(isolate_);
+
+  // An event that can't be converted is dropped by itself, as SendUpdate
+  // would, and the rest of the batch is still handled
+  auto docs = v8::Array::New(isolate_);
+  auto metas = v8::Array::New(isolate_);
+  int count = 0;
+  for (const auto event : events) {
+    const auto doc = flatbuf::payload::GetPayload(
+        static_cast<const void *>(event->payload.payload.data()));
+    const auto value = doc->value();
+
+    const auto value_str = std::string_view(value->c_str(), value->size());
+
+    v8::Local<v8::Value> doc_v8val;
+    v8::Local<v8::Value> meta_v8val;
+    auto result = false;
+    if (!TO_LOCAL(v8::JSON::Parse(context, v8Str(isolate_, value_str)),
+                  &doc_v8val) ||
+        !NewMetaObject(context, event->header, &meta_v8val) ||
+        !TO(docs->Set(context, count, doc_v8val), &result) ||
+        !TO(metas->Set(context, count, meta_v8val), &result)) {
+      LOG(logDebug) << "Unable to convert the event for OnUpdateBatch, meta: "
+                    << RU(event->header.GetMetadataString()) << std::endl;
+      ++on_update_failure;
+      try_catch.Reset();
+      continue;
+    }
+    ++count;
+  }
+  if (count == 0) {
+    UpdateHistogram(start_time);
+    return kToLocalFailed;
+  }
+
+  RetryWithFixedBackoff(std::numeric_limits<int>::max(), 10,
+                        IsTerminatingRetriable, IsExecutionTerminating,
+                        isolate_);
+
+  v8::Local<v8::Value> args[2] = {docs, metas};
+  auto on_doc_update_batch = on_update_batch_.Get(isolate_);
+  execute_start_time_ = Time::now();
+  UnwrapData(isolate_)->is_executing_ = true;
+  on_doc_update_batch->Call(context->Global(), 2, args);
+  UnwrapData(isolate_)->is_executing_ = false;
+  auto query_mgr = UnwrapData(isolate_)->query_mgr;
+  query_mgr->ClearQueries();
+  FlushBucketWrites();
+
+  if (try_catch.HasCaught()) {
+    UpdateHistogram(start_time);
+    on_update_failure += count;
+    auto emsg = ExceptionString(isolate_, context, &try_catch);
+    LOG(logDebug) << "OnUpdateBatch Exception: " << emsg << std::endl;
+    CodeInsight::Get(isolate_).AccumulateException(try_catch);
+    return kOnUpdateCallFail;
+  }
+
+  on_update_success += count;
+  UpdateHistogram(start_time);
+  return kSuccess;
+}
+
+// The isolate must be locked and context_ entered by the caller, see
+// HandleDCPBatch
+int V8Worker::SendDeleteBatch(
+    const std::vector<const WorkerMessage *> &events) {
+  const auto start_time = Time::now();
+
+  v8::HandleScope handle_scope(isolate_);
+  auto context = isolate_->GetCurrentContext();
+  v8::TryCatch try_catch(isolate_);
+
+  auto metas = v8::Array::New(isolate_);
+  int count = 0;
+  for (const auto event : events) {
+    v8::Local<v8::Value> meta_v8val;
+    auto result = false;
+    if (!NewMetaObject(context, event->header, &meta_v8val) ||
+        !TO(metas->Set(context, count, meta_v8val), &result)) {
+      LOG(logDebug) << "Unable to convert the event for OnDeleteBatch, meta: "
+                    << RU(event->header.GetMetadataString()) << std::endl;
+      ++on_delete_failure;
+      try_catch.Reset();
+      continue;
+    }
+    ++count;
+  }
+  if (count == 0) {
+    UpdateHistogram(start_time);
+    return kToLocalFailed;
+  }
+
+  RetryWithFixedBackoff(std::numeric_limits<int>::max(), 10,
+                        IsTerminatingRetriable, IsExecutionTerminating,
+                        isolate_);
+
+  v8::Local<v8::Value> args[1] = {metas};
+  auto on_doc_delete_batch = on_delete_batch_.Get(isolate_);
+  execute_start_time_ = Time::now();
+  UnwrapData(isolate_)->is_executing_ = true;
+  on_doc_delete_batch->Call(context->Global(), 1, args);
+  UnwrapData(isolate_)->is_executing_ = false;
+  auto query_mgr = UnwrapData(isolate_)->query_mgr;
+  query_mgr->ClearQueries();
+  FlushBucketWrites();
+
+  if (try_catch.HasCaught()) {
+    LOG(logDebug) << "OnDeleteBatch Exception: "
+                  << ExceptionString(isolate_, context, &try_catch)
+                  << std::endl;
+    UpdateHistogram(start_time);
+    on_delete_failure += count;
+    return kOnDeleteCallFail;
+  }
+
+  UpdateHistogram(start_time);
+  on_delete_success += count;
+  return kSuccess;
+}
+
+// Replaces each of the arguments with an array holding just that argument
+bool V8Worker::WrapInArrays(const v8::Local<v8::Context> &context,
+                            v8::Local<v8::Value> *args, int args_len) const {
+  for (int i = 0; i < args_len; ++i) {
+    auto array = v8::Array::New(isolate_, 1);
+    auto result = false;
+    if (!TO(array->Set(context, 0, args[i]), &result) || !result) {
+      return false;
+    }
+    args[i] = array;
+  }
+  return true;
+}
+
 void V8Worker::SendTimer(std::string callback, std::string timer_ctx) {
   LOG(logTrace) << "Got timer event, context:" << RU(timer_ctx)
                 << " callback:" << callback << std::endl;
@@ -812,6 +1319,7 @@ void V8Worker::SendTimer(std::string callback, std::string timer_ctx) {
 
   auto query_mgr = UnwrapData(isolate_)->query_mgr;
   query_mgr->ClearQueries();
+  FlushBucketWrites();
 }
 
 void V8Worker::StartDebugger() {
@@ -858,7 +1366,7 @@ void V8Worker::PushFront(std::unique_ptr<WorkerMessage> worker_msg) {
                 << static_cast<int16_t>(worker_msg->header.event) << " opcode: "
                 << static_cast<int16_t>(worker_msg->header.opcode)
                 << " partition: " << worker_msg->header.partition
-                << " metadata: " << RU(worker_msg->header.metadata)
+                << " metadata: " << RU(worker_msg->header.GetMetadataString())
                 << std::endl;
   worker_queue_->PushFront(std::move(worker_msg));
 }
@@ -868,7 +1376,7 @@ void V8Worker::PushBack(std::unique_ptr<WorkerMessage> worker_msg) {
                 << static_cast<int16_t>(worker_msg->header.event) << " opcode: "
                 << static_cast<int16_t>(worker_msg->header.opcode)
                 << " partition: " << worker_msg->header.partition
-                << " metadata: " << RU(worker_msg->header.metadata)
+                << " metadata: " << RU(worker_msg->header.GetMetadataString())
                 << std::endl;
   worker_queue_->PushBack(std::move(worker_msg));
 }
@@ -978,16 +1486,17 @@ std::vector<uv_buf_t> V8Worker::BuildResponse(const std::string &payload,
   return messages;
 }
 
-int V8Worker::ParseMetadata(const std::string &metadata, int &vb_no,
+int V8Worker::ParseMetadata(std::string_view metadata, int &vb_no,
                             uint64_t &seq_no) const {
   int skip_ack;
   return ParseMetadataWithAck(metadata, vb_no, seq_no, skip_ack, false);
 }
 
-int V8Worker::ParseMetadataWithAck(const std::string &metadata_str, int &vb_no,
+int V8Worker::ParseMetadataWithAck(std::string_view metadata_str, int &vb_no,
                                    uint64_t &seq_no, int &skip_ack,
                                    const bool ack_check) const {
-  auto metadata = nlohmann::json::parse(metadata_str, nullptr, false);
+  auto metadata = nlohmann::json::parse(metadata_str.begin(),
+                                        metadata_str.end(), nullptr, false);
   if (metadata.is_discarded()) {
     return kJSONParseFailed;
   }
@@ -1114,6 +1623,18 @@ void V8Worker::TaskDurationWatcher() {
   }
 }
 
+// The debugger suspends the watcher, each op then gets the whole budget
+nsecs V8Worker::GetRemainingExecutionTime() const {
+  const nsecs max_duration(max_task_duration_);
+  if (debugger_started_) {
+    return max_duration;
+  }
+
+  const auto elapsed =
+      std::chrono::duration_cast<nsecs>(Time::now() - execute_start_time_);
+  return std::max(max_duration - elapsed, nsecs::zero());
+}
+
 void V8Worker::UpdatePartitions(const std::unordered_set<int64_t> &vbuckets) {
   partitions_ = vbuckets;
 }
@@ -1154,6 +1675,21 @@ std::string GetFunctionInstanceID(v8::Isolate *isolate) {
   return w->GetFunctionInstanceID();
 }
 
+std::chrono::nanoseconds GetRemainingExecutionTime(v8::Isolate *isolate) {
+  auto w = UnwrapData(isolate)->v8worker;
+  return w->GetRemainingExecutionTime();
+}
+
+void FlushBucketWrites(v8::Isolate *isolate) {
+  auto w = UnwrapData(isolate)->v8worker;
+  w->FlushBucketWrites();
+}
+
+void FlushBucketWrites(v8::Isolate *isolate, const Bucket *reader) {
+  auto w = UnwrapData(isolate)->v8worker;
+  w->FlushBucketWrites(reader);
+}
+
 void UpdateCurlLatencyHistogram(
     v8::Isolate *isolate,
     const std::chrono::high_resolution_clock::time_point &start) {